@@ -0,0 +1,40 @@
+#ifndef EKG_GPU_VK_BLUR_H
+#define EKG_GPU_VK_BLUR_H
+
+#include "ekg/gpu/gpu_vk.hpp"
+#include "ekg/gpu/gpu_vk_pipeline.hpp"
+#include <vector>
+
+namespace ekg::gpu {
+    /*
+     * One fullscreen triangle sampling an image through the 9 taps gaussian of
+     * shaders/blur.frag along `direction` (in texels); two passes make a separable
+     * blur and a zero direction copies. Every source slot owns a descriptor set,
+     * written by `set_source()` whenever the graph owning the sampled view compiles
+     * (e.g from `render_graph::on_compiled`), so `draw()` only binds it.
+     */
+    class blur_renderer {
+    protected:
+        VkDescriptorSetLayout vk_descriptor_set_layout {};
+        std::vector<VkDescriptorPool> descriptor_pools {};
+        std::vector<VkDescriptorSet> source_sets {};
+        VkSampler vk_sampler {};
+        VkPipelineLayout vk_pipeline_layout {};
+    public:
+        ekg::gpu::pipeline pipeline {};
+
+        /* Reads the SPIR-V only, it may run before the device exists. */
+        bool load_shaders(std::string_view vertex_shader_path, std::string_view fragment_shader_path);
+        bool init();
+        void destroy();
+
+        /* Any time after `init()`, every window graph takes the slots it samples from. */
+        bool add_source(uint32_t &source);
+        /* Outside of recording, no submitted frame may still read the set. */
+        void set_source(uint32_t source, VkImageView view);
+
+        void draw(VkCommandBuffer command_buffer, uint32_t source, float direction_x, float direction_y);
+    };
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef EKG_GPU_VK_HOST_ALLOCATOR_H
+#define EKG_GPU_VK_HOST_ALLOCATOR_H
+
+#include "ekg/gpu/gpu_vk.hpp"
+#include <atomic>
+#include <array>
+#include <vector>
+
+namespace ekg::gpu {
+    /* Indexed by VkSystemAllocationScope, command (0) to instance (4). */
+    constexpr uint32_t host_allocation_scope_count {5};
+
+    struct host_allocation_stats {
+        std::array<uint64_t, host_allocation_scope_count> allocations {};
+        std::array<uint64_t, host_allocation_scope_count> bytes {};
+        std::array<uint64_t, host_allocation_scope_count> internal_allocations {};
+        uint64_t heap_allocations {};
+        uint64_t arena_allocations {};
+        uint64_t arena_overflows {};
+    };
+
+    /*
+     * Host memory the driver asks for through VkAllocationCallbacks.
+     * Command scope allocations live only for the duration of one Vulkan call,
+     * so they are bumped from an arena rewound on every `begin_frame()`; the
+     * others go to the heap. Every allocation is counted per scope.
+     */
+    class host_allocator {
+    protected:
+        VkAllocationCallbacks callbacks {};
+
+        std::array<std::atomic<uint64_t>, host_allocation_scope_count> allocations {};
+        std::array<std::atomic<uint64_t>, host_allocation_scope_count> bytes {};
+        std::array<std::atomic<uint64_t>, host_allocation_scope_count> internal_allocations {};
+        std::atomic<uint64_t> heap_allocations {};
+        std::atomic<uint64_t> arena_allocations {};
+        std::atomic<uint64_t> arena_overflows {};
+        std::atomic<uint64_t> live_bytes {};
+
+        std::vector<char> arena {};
+        std::atomic<size_t> arena_offset {};
+
+        ekg::gpu::host_allocation_stats frame_begin_stats {};
+        ekg::gpu::host_allocation_stats frame_stats {};
+
+        uint64_t interval_frames {};
+        uint64_t interval_heap_frames {};
+        uint64_t interval_heap_allocations {};
+        uint64_t interval_worst_heap_allocations {};
+
+        void *alloc_heap(size_t size, size_t alignment, VkSystemAllocationScope scope);
+        void *alloc_arena(size_t size, size_t alignment, VkSystemAllocationScope scope);
+
+        static VKAPI_ATTR void* VKAPI_CALL allocation(void *user_data, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static VKAPI_ATTR void* VKAPI_CALL reallocation(void *user_data, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static VKAPI_ATTR void VKAPI_CALL free(void *user_data, void *memory);
+        static VKAPI_ATTR void VKAPI_CALL internal_allocation(void *user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+        static VKAPI_ATTR void VKAPI_CALL internal_free(void *user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+    public:
+        /* When set, `end_frame()` logs every frame that still touched the heap. */
+        bool strict_steady_state {};
+
+        /* Every this many frames `end_frame()` logs how many of them touched the heap, 0 disables it. */
+        uint32_t report_interval_frames {};
+
+        void init(size_t arena_size = 256 * 1024);
+        const VkAllocationCallbacks *get_callbacks();
+
+        /* Must not overlap a Vulkan call on another thread, the arena is rewound here. */
+        void begin_frame();
+        void end_frame();
+
+        ekg::gpu::host_allocation_stats get_stats();
+        ekg::gpu::host_allocation_stats &get_frame_stats();
+        uint64_t get_live_bytes();
+        void report();
+        void report_frame();
+    };
+
+    extern host_allocator host;
+}
+
+#endif
@@ -3,14 +3,29 @@
 
 #include "ekg/gpu/gpu_vk.hpp"
 #include <iostream>
+#include <vector>
 
 namespace ekg {
     namespace gpu {
         struct pipeline {
             VkPipeline pipeline_info {};
+            std::vector<char> vertex_shader_code {};
+            std::vector<char> fragment_shader_code {};
+            std::vector<VkVertexInputBindingDescription> vertex_bindings {};
+            std::vector<VkVertexInputAttributeDescription> vertex_attributes {};
+
+            /* Variant state, the defaults are the opaque tessellated geometry pipeline; `samples` must match the render pass. */
+            VkPrimitiveTopology topology {VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
+            VkCullModeFlags cull_mode {VK_CULL_MODE_BACK_BIT};
+            VkSampleCountFlagBits samples {VK_SAMPLE_COUNT_1_BIT};
+            bool alpha_blend {};
+            VkPipelineLayout layout {};
         };
     }
 
+    /* Reads the SPIR-V binaries only, no Vulkan object is touched so it can run before the device exists. */
+    bool load_pipeline_shaders(ekg::gpu::pipeline&, std::string_view, std::string_view);
+    bool create_pipeline(ekg::gpu::pipeline&);
     bool create_pipeline(ekg::gpu::pipeline&, std::string_view, std::string_view);
 }
 
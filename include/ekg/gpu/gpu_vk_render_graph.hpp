@@ -0,0 +1,151 @@
+#ifndef EKG_GPU_VK_RENDER_GRAPH_H
+#define EKG_GPU_VK_RENDER_GRAPH_H
+
+#include "ekg/gpu/gpu_vk.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <functional>
+
+namespace ekg::gpu {
+    /* How a pass touches an image, each one maps to a stage, an access mask and a layout. */
+    constexpr uint32_t access_color_attachment_write {0};
+    constexpr uint32_t access_color_attachment_read_write {1};
+    constexpr uint32_t access_sampled {2};
+    constexpr uint32_t access_transfer_read {3};
+    constexpr uint32_t access_transfer_write {4};
+
+    struct render_pass_attachment {
+        VkFormat format {};
+        VkSampleCountFlagBits samples {VK_SAMPLE_COUNT_1_BIT};
+        VkAttachmentLoadOp load_op {VK_ATTACHMENT_LOAD_OP_CLEAR};
+        VkAttachmentStoreOp store_op {VK_ATTACHMENT_STORE_OP_STORE};
+        VkImageLayout layout {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    };
+
+    /*
+     * Render passes keyed by attachment signature and framebuffers keyed by render pass,
+     * views and extent; both are created on the first miss and kept until `destroy()`.
+     * Framebuffers over views about to be destroyed must be dropped first, a new view may
+     * reuse the handle. Layout transitions are left to barriers, so every attachment keeps one layout.
+     */
+    class render_pass_cache {
+    protected:
+        std::map<std::vector<uint32_t>, VkRenderPass> render_passes {};
+        std::map<std::vector<uint64_t>, VkFramebuffer> framebuffers {};
+        std::vector<uint64_t> framebuffer_key {};
+    public:
+        VkRenderPass get_render_pass(const std::vector<ekg::gpu::render_pass_attachment> &attachments);
+        VkFramebuffer get_framebuffer(VkRenderPass render_pass, const std::vector<VkImageView> &views, VkExtent2D extent);
+        void clear_framebuffers();
+        void clear_framebuffers(const std::vector<VkImageView> &views);
+        void destroy();
+    };
+
+    struct render_graph_access {
+        uint32_t resource {};
+        uint32_t access {};
+    };
+
+    struct render_graph_resource {
+        std::string tag {};
+        VkFormat format {};
+        VkExtent2D extent {};
+        bool imported {};
+        bool relative {};
+        VkPipelineStageFlags imported_stage {};
+        VkImageLayout final_layout {VK_IMAGE_LAYOUT_UNDEFINED};
+
+        VkImage image {};
+        VkImageView view {};
+        VkImageUsageFlags usage {};
+        bool attachment_only {true};
+        bool lazily_allocated {};
+        uint32_t first_pass {};
+        uint32_t last_pass {};
+        uint32_t memory_block {};
+    };
+
+    struct render_graph_pass {
+        std::string tag {};
+        std::vector<ekg::gpu::render_graph_access> accesses {};
+        std::function<void(VkCommandBuffer)> record {};
+        bool clear {};
+        VkClearColorValue clear_color {};
+
+        VkRenderPass render_pass {};
+        std::vector<uint32_t> color_attachments {};
+        VkExtent2D extent {};
+    };
+
+    struct render_graph_transition {
+        uint32_t resource {};
+        VkAccessFlags src_access {};
+        VkAccessFlags dst_access {};
+        VkImageLayout old_layout {};
+        VkImageLayout new_layout {};
+    };
+
+    /* Everything one `vkCmdPipelineBarrier` call emits before a pass (or after the last one). */
+    struct render_graph_barrier_batch {
+        VkPipelineStageFlags src_stage {};
+        VkPipelineStageFlags dst_stage {};
+        std::vector<ekg::gpu::render_graph_transition> transitions {};
+    };
+
+    struct render_graph_memory_block {
+        VkDeviceMemory memory {};
+        VkDeviceSize size {};
+        uint32_t memory_type_bits {~0u};
+        bool lazily_allocated {};
+        std::vector<uint32_t> resources {};
+    };
+
+    /*
+     * Passes declare the images they read and write, `compile()` orders nothing (passes
+     * run as added) but derives every layout transition, batches them into one barrier
+     * call per pass boundary, drops read-after-read barriers, and allocates the transient
+     * images: the ones with disjoint lifetimes alias the same memory block, the
+     * attachment-only ones go to lazily allocated memory where the device has it.
+     */
+    class render_graph {
+    protected:
+        std::vector<ekg::gpu::render_graph_resource> resources {};
+        std::vector<ekg::gpu::render_graph_pass> passes {};
+        std::vector<ekg::gpu::render_graph_barrier_batch> batches {};
+        std::vector<ekg::gpu::render_graph_memory_block> memory_blocks {};
+        ekg::gpu::render_pass_cache *cache {};
+        bool compiled {};
+        bool reported {};
+
+        std::vector<VkImageMemoryBarrier> image_barriers {};
+        std::vector<VkImageView> attachment_views {};
+        std::vector<VkClearValue> clear_values {};
+
+        bool allocate_transients();
+        void plan_barriers();
+        void emit(VkCommandBuffer command_buffer, const ekg::gpu::render_graph_barrier_batch &batch);
+    public:
+        /* Called after every successful `compile()`, transient views are new then and descriptors pointing at them are stale. */
+        std::function<void(ekg::gpu::render_graph&)> on_compiled {};
+
+        void set_cache(ekg::gpu::render_pass_cache *render_pass_cache);
+
+        uint32_t import_image(std::string_view tag, VkFormat format, VkExtent2D extent, VkPipelineStageFlags ready_stage, VkImageLayout final_layout);
+        /* A zero extent follows the first imported image, so a window sized target survives a resize. */
+        uint32_t create_image(std::string_view tag, VkFormat format, VkExtent2D extent = {});
+        void set_extent(uint32_t resource, VkExtent2D extent);
+        void set_image(uint32_t resource, VkImage image, VkImageView view);
+        VkImageView get_view(uint32_t resource);
+
+        /* A pass with color attachment accesses is recorded inside a cached render pass, otherwise outside of any. */
+        void add_pass(std::string_view tag, const std::vector<ekg::gpu::render_graph_access> &accesses, const std::function<void(VkCommandBuffer)> &record, bool clear = false, VkClearColorValue clear_color = {});
+
+        bool compile();
+        /* Never compiles while recording, false when the graph changed since the last `compile()`. */
+        bool execute(VkCommandBuffer command_buffer);
+        void destroy();
+    };
+}
+
+#endif
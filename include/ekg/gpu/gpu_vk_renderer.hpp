@@ -3,9 +3,14 @@
 
 #include <iostream>
 #include "gpu_vk.hpp"
+#include "ekg/util/task_graph.hpp"
+#include "ekg/gpu/gpu_vk_render_graph.hpp"
+#include "ekg/gpu/gpu_vk_window.hpp"
 #include <vector>
+#include <memory>
 #include <SDL2/SDL.h>
 #include <optional>
+#include <functional>
 
 namespace ekg::gpu {
     struct queue_families {
@@ -15,12 +20,10 @@ namespace ekg::gpu {
         bool is_complete();
     };
 
-    struct swap_chain_support_details {
-        VkSurfaceCapabilitiesKHR capabilities {};
-        std::vector<VkSurfaceFormatKHR> formats {};
-        std::vector<VkPresentModeKHR> present_modes {};
-    };
-
+    /*
+     * The device context shared by every window: instance, device, queues, pipeline cache,
+     * command buffer and render pass cache. Windows only own their surface and swap chain.
+     */
     class vk_renderer {
     protected:
         const std::vector<const char*> validation_layers {
@@ -33,46 +36,100 @@ namespace ekg::gpu {
 
         static VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT message_severity, VkDebugUtilsMessageTypeFlagsEXT message_type, const VkDebugUtilsMessengerCallbackDataEXT* call_back_data, void* user_data);
         static VkResult CreateDebugUtilsMessengerEXT(VkInstance &instance, const VkDebugUtilsMessengerCreateInfoEXT* create_info, const VkAllocationCallbacks* allocator, VkDebugUtilsMessengerEXT* debug_messenger);
+
+        /* Reused by `end_frame()` so the batched submit and present do not allocate. */
+        std::vector<VkSemaphore> wait_semaphores {};
+        std::vector<VkPipelineStageFlags> wait_stages {};
+        std::vector<VkSwapchainKHR> present_swap_chains {};
+        std::vector<uint32_t> present_image_indices {};
+        std::vector<VkResult> present_results {};
+        std::vector<ekg::gpu::vk_window*> present_windows {};
+
+        void reserve_frame_lists();
     public:
-        SDL_Window* sdl_window {};
         bool enable_validation_layers {};
-        std::vector<VkImage> swap_chain_images {};
-        std::vector<VkImageView> swap_chain_image_view {};
-        std::vector<VkFramebuffer> swap_chain_framebuffer {};
         VkInstance vk_instance {};
         VkDebugUtilsMessengerEXT vk_debug_messenger {};
-        VkSurfaceKHR vk_surface {};
         VkPhysicalDevice vk_physical_device {};
         VkDevice vk_device {};
         VkQueue vk_graphics_queue {};
         VkQueue vk_present_queue {};
-        VkSwapchainKHR vk_swap_chain {};
-        VkFormat vk_swap_chain_image_format {};
-        VkExtent2D vk_swap_chain_extent {};
+        VkPipelineCache vk_pipeline_cache {};
         VkRenderPass vk_render_pass {};
+        VkSampleCountFlagBits vk_render_pass_samples {VK_SAMPLE_COUNT_1_BIT};
         VkPipelineLayout vk_pipeline_layout {};
+        VkCommandPool vk_command_pool {};
+        VkCommandBuffer vk_command_buffer {};
+        VkSemaphore vk_render_finished_semaphore {};
+        VkFence vk_in_flight_fence {};
+
+        /*
+         * The first window picks the physical device and present queue; `vk_render_pass` is the
+         * cached clear-and-store pass over its swap chain format, the one pipelines are built against,
+         * so a pipeline `samples` must be `vk_render_pass_samples`.
+         */
+        std::vector<std::unique_ptr<ekg::gpu::vk_window>> windows {};
+        ekg::gpu::render_pass_cache render_pass_cache {};
+
+        /*
+         * Tasks added here before `setup()` run together with the renderer phases,
+         * they may depend on any phase tag e.g "render pass" or "pipeline layout";
+         * `setup()` is false when any of them (or any phase) failed.
+         */
+        ekg::task_graph startup {};
+        uint32_t startup_thread_count {};
 
-        std::vector<const char*> &get_extensions();
+        /*
+         * Adds the passes to a window graph (its swap chain is already imported as `swap_chain_resource`),
+         * called for every window once the startup graph succeeded and right away for later windows.
+         */
+        std::function<bool(ekg::gpu::vk_window&)> build_render_graph {};
+
+        /*
+         * Windows added before `setup()` are created with the startup graph, later ones right away;
+         * null when one added after `setup()` could not be created, it is dropped then.
+         */
+        ekg::gpu::vk_window *add_window(SDL_Window *sdl_window);
+
+        /* Null when the SDL window id is not one of `windows`, e.g to flag a resized one `out_of_date`. */
+        ekg::gpu::vk_window *find_window(uint32_t sdl_window_id);
+
+        std::vector<const char*> get_extensions();
         void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT &create_info);
-        void create_instance();
-        void setup();
-        void create_surface();
-        void pick_physical_device();
-        void setup_debug_messenger();
+        bool create_instance();
+        bool setup();
+        void quit();
+        bool create_surfaces();
+        bool pick_physical_device();
+        bool setup_debug_messenger();
         bool is_device_suitable(VkPhysicalDevice device);
         void find_queue_families(ekg::gpu::queue_families &indices, VkPhysicalDevice &device);
         bool check_device_extension_support(VkPhysicalDevice &device);
-        void query_swap_chain_support(ekg::gpu::swap_chain_support_details &details, VkPhysicalDevice &device);
-        void create_logical_device();
-        void create_swap_chain();
-        void create_image_views();
-        void create_render_pass();
-        void create_graphics_pipeline();
-
-        VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR> &available_formats);
-        VkPresentModeKHR choose_swap_present_mode_format(const std::vector<VkPresentModeKHR> &available_present_modes);
-        VkExtent2D choose_swap_extent(const VkSurfaceCapabilitiesKHR &capabilities);
-        bool create_shader_module(VkShaderModule &shader_module, const std::string &code);
+        void query_swap_chain_support(ekg::gpu::swap_chain_support_details &details, VkPhysicalDevice &device, VkSurfaceKHR surface);
+        bool create_logical_device();
+        bool create_swap_chains();
+        bool create_image_views();
+        bool create_render_pass();
+        bool create_graphics_pipeline();
+        bool create_render_graphs();
+        bool create_command_buffers();
+        bool create_sync_objects();
+
+        /*
+         * Frame flow: `begin_frame()` (acquires every window, null when none could), `graph.execute()`
+         * of each `acquired` window into the one command buffer, and `end_frame()` (one submit waiting
+         * on every acquire, one present over every swap chain). Out of date swap chains are
+         * recreated by the next acquire of their window. A frame that fails recording, e.g a
+         * `graph.execute()` returning false, goes to `cancel_frame()` instead of `end_frame()`.
+         */
+        VkCommandBuffer begin_frame();
+        void end_frame();
+        void cancel_frame();
+
+        bool find_memory_type(uint32_t &memory_type_index, uint32_t type_filter, VkMemoryPropertyFlags properties);
+        bool create_buffer(VkBuffer &buffer, VkDeviceMemory &buffer_memory, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+
+        bool create_shader_module(VkShaderModule &shader_module, const std::vector<char> &code);
     };
 
     extern vk_renderer vulkan;
@@ -0,0 +1,56 @@
+#ifndef EKG_GPU_VK_SDF_H
+#define EKG_GPU_VK_SDF_H
+
+#include "ekg/gpu/gpu_vk.hpp"
+#include "ekg/gpu/gpu_vk_pipeline.hpp"
+
+namespace ekg::gpu {
+    constexpr uint32_t sdf_kind_rect {0};
+    constexpr uint32_t sdf_kind_rounded_rect {1};
+    constexpr uint32_t sdf_kind_circle {2};
+    constexpr uint32_t sdf_kind_border {3};
+    constexpr uint32_t sdf_kind_shadow {4};
+
+    /*
+     * One instanced quad, evaluated as a signed distance in shaders/sdf_primitive.frag;
+     * rect is x, y, w, h in pixels, colors are packed rgba8 with red in the lowest byte.
+     * `border_width` draws a border over the fill of any kind but shadow, `softness`
+     * is the shadow blur radius.
+     */
+    struct sdf_primitive {
+        float rect[4] {};
+        float radius {};
+        float border_width {};
+        float softness {};
+        uint32_t kind {};
+        uint32_t fill_color {};
+        uint32_t border_color {};
+        uint32_t padding[2] {};
+    };
+
+    static_assert(sizeof(ekg::gpu::sdf_primitive) == 48);
+
+    class sdf_renderer {
+    protected:
+        uint32_t capacity {};
+        uint32_t primitive_count {};
+
+        VkBuffer instance_buffer {};
+        VkDeviceMemory instance_memory {};
+        void *mapped_instances {};
+        VkPipelineLayout vk_pipeline_layout {};
+    public:
+        ekg::gpu::pipeline pipeline {};
+
+        /* Reads the SPIR-V only, it may run before the device exists. */
+        bool load_shaders(std::string_view vertex_shader_path, std::string_view fragment_shader_path);
+        bool init(uint32_t primitive_capacity);
+        void destroy();
+
+        /* Write after `begin_frame()`, same as the widget tessellator descriptors. */
+        void upload(const ekg::gpu::sdf_primitive *primitives, uint32_t count);
+        void draw(VkCommandBuffer command_buffer, VkExtent2D viewport);
+    };
+}
+
+#endif
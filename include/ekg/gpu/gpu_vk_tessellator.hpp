@@ -0,0 +1,78 @@
+#ifndef EKG_GPU_VK_TESSELLATOR_H
+#define EKG_GPU_VK_TESSELLATOR_H
+
+#include "ekg/gpu/gpu_vk.hpp"
+#include "ekg/gpu/gpu_vk_pipeline.hpp"
+#include <vector>
+
+namespace ekg::gpu {
+    constexpr uint32_t widget_flag_visible {1};
+
+    /*
+     * The only per-widget data the CPU writes, std430 mirror of `widget_descriptor`
+     * in shaders/widget_tessellate.comp; rect and scissor are x, y, w, h in pixels
+     * and color is packed rgba8 with red in the lowest byte.
+     */
+    struct widget_descriptor {
+        float rect[4] {};
+        float scissor[4] {};
+        uint32_t color {};
+        uint32_t flags {};
+        uint32_t padding[2] {};
+    };
+
+    static_assert(sizeof(ekg::gpu::widget_descriptor) == 48);
+
+    struct widget_vertex {
+        float position[2] {};
+        uint32_t color {};
+        uint32_t padding {};
+    };
+
+    /*
+     * GPU-driven widget path: a compute pass expands the descriptors into quads,
+     * culling the ones outside scissor/viewport, and fills the indirect command
+     * the render pass draws with, so no vertex is built on the CPU.
+     */
+    class widget_tessellator {
+    protected:
+        uint32_t capacity {};
+        uint32_t widget_count {};
+        std::vector<char> compute_shader_code {};
+
+        VkBuffer descriptor_buffer {};
+        VkDeviceMemory descriptor_memory {};
+        void *mapped_descriptors {};
+
+        VkBuffer vertex_buffer {};
+        VkDeviceMemory vertex_memory {};
+        VkBuffer index_buffer {};
+        VkDeviceMemory index_memory {};
+        VkBuffer indirect_buffer {};
+        VkDeviceMemory indirect_memory {};
+
+        VkDescriptorSetLayout vk_descriptor_set_layout {};
+        VkDescriptorPool vk_descriptor_pool {};
+        VkDescriptorSet vk_descriptor_set {};
+        VkPipelineLayout vk_pipeline_layout {};
+        VkPipeline vk_pipeline {};
+
+        bool create_buffers();
+        bool create_descriptor_set();
+        bool create_compute_pipeline();
+    public:
+        static void set_vertex_input(ekg::gpu::pipeline &pipeline);
+
+        /* Reads the SPIR-V only, it may run before the device exists. */
+        bool load_shader(std::string_view compute_shader_path);
+        bool init(uint32_t widget_capacity);
+        void destroy();
+
+        /* Write after `begin_frame()`, the previous frame is done reading the descriptor buffer by then. */
+        void upload(const ekg::gpu::widget_descriptor *descriptors, uint32_t count);
+        void dispatch(VkCommandBuffer command_buffer, VkExtent2D viewport);
+        void draw(VkCommandBuffer command_buffer, ekg::gpu::pipeline &pipeline);
+    };
+}
+
+#endif
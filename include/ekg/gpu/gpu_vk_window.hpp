@@ -0,0 +1,56 @@
+#ifndef EKG_GPU_VK_WINDOW_H
+#define EKG_GPU_VK_WINDOW_H
+
+#include "gpu_vk.hpp"
+#include "ekg/gpu/gpu_vk_render_graph.hpp"
+#include <vector>
+#include <SDL2/SDL.h>
+
+namespace ekg::gpu {
+    struct swap_chain_support_details {
+        VkSurfaceCapabilitiesKHR capabilities {};
+        std::vector<VkSurfaceFormatKHR> formats {};
+        std::vector<VkPresentModeKHR> present_modes {};
+    };
+
+    /*
+     * The per window state: surface, swap chain and the render graph drawing into it.
+     * Device, queues, pipelines and every buffer are shared through `ekg::gpu::vulkan`,
+     * so a window costs its swap chain images and one semaphore.
+     */
+    class vk_window {
+    public:
+        SDL_Window* sdl_window {};
+        VkSurfaceKHR vk_surface {};
+        VkSwapchainKHR vk_swap_chain {};
+        VkFormat vk_swap_chain_image_format {};
+        VkExtent2D vk_swap_chain_extent {};
+        std::vector<VkImage> swap_chain_images {};
+        std::vector<VkImageView> swap_chain_image_view {};
+        VkSemaphore vk_image_available_semaphore {};
+        uint32_t current_image_index {};
+        bool acquired {};
+
+        /* Set on resize or by an out of date/suboptimal acquire or present, the next `acquire()` recreates first. */
+        bool out_of_date {};
+
+        /* The swap chain image is imported as `swap_chain_resource`, bound again on every acquire. */
+        ekg::gpu::render_graph graph {};
+        uint32_t swap_chain_resource {};
+
+        bool create_surface();
+        bool create_swap_chain(VkSwapchainKHR old_swap_chain = VK_NULL_HANDLE);
+        bool create_image_views();
+        bool create_sync_objects();
+        bool create_render_graph();
+        bool recreate_swap_chain();
+        bool acquire();
+        void destroy();
+
+        VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR> &available_formats);
+        VkPresentModeKHR choose_swap_present_mode_format(const std::vector<VkPresentModeKHR> &available_present_modes);
+        VkExtent2D choose_swap_extent(const VkSurfaceCapabilitiesKHR &capabilities);
+    };
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef EKG_UTIL_TASK_GRAPH_H
+#define EKG_UTIL_TASK_GRAPH_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace ekg {
+    struct task {
+        std::string tag {};
+        std::function<bool()> function {};
+        std::vector<std::string> dependencies {};
+        std::vector<size_t> dependents {};
+        size_t pending_dependencies {};
+        bool failed {};
+        bool skipped {};
+        bool main_thread {};
+
+        uint32_t thread_index {};
+        uint64_t begin_us {};
+        uint64_t end_us {};
+    };
+
+    /*
+     * Runs a set of tagged tasks on a small thread pool; a task is started
+     * only when every task listed as dependency (by tag) is done. A task
+     * returning false fails the run and every task depending on it, even
+     * transitively, is skipped instead of run on whatever it left behind.
+     * A `main_thread` task only runs on the thread calling `run()`, e.g one
+     * touching SDL windows, which several platforms restrict to that thread.
+     */
+    class task_graph {
+    protected:
+        std::vector<ekg::task> tasks {};
+        std::deque<size_t> ready_queue {};
+        std::deque<size_t> main_thread_queue {};
+        std::mutex mutex {};
+        std::condition_variable condition {};
+        size_t completed_tasks {};
+        size_t failed_tasks {};
+        uint64_t elapsed_us {};
+
+        bool resolve();
+        void push_ready(size_t index);
+        void work(uint32_t thread_index, uint64_t begin_us);
+    public:
+        void add(std::string_view tag, const std::function<bool()> &function, const std::vector<std::string> &dependencies = {}, bool main_thread = false);
+        bool run(uint32_t thread_count = 0);
+        void report(std::string_view graph_tag);
+        void clear();
+
+        const std::vector<ekg::task> &get_tasks();
+        uint64_t get_elapsed_us();
+    };
+}
+
+#endif
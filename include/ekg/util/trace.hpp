@@ -0,0 +1,51 @@
+#ifndef EKG_UTIL_TRACE_H
+#define EKG_UTIL_TRACE_H
+
+#include <iostream>
+
+/*
+ * CPU zone tracer, enabled by building with `EKG_TRACE` defined (cmake -DEKG_TRACE=ON).
+ * Without it every macro expands to nothing and no tracer code is compiled.
+ * Zone names must be string literals, only the pointer is recorded.
+ */
+#ifdef EKG_TRACE
+#define EKG_TRACE_CONCAT_IMPL(a, b) a##b
+#define EKG_TRACE_CONCAT(a, b) EKG_TRACE_CONCAT_IMPL(a, b)
+#define EKG_TRACE_SCOPE(name) ekg::trace::scope EKG_TRACE_CONCAT(ekg_trace_scope_, __LINE__) {name}
+#define EKG_TRACE_FRAME(frame, image_indices, window_count) ekg::trace::frame_mark(frame, image_indices, window_count)
+#define EKG_TRACE_INSTALL_SIGNAL() ekg::trace::install_signal()
+#define EKG_TRACE_REQUEST_DUMP() ekg::trace::request_dump()
+#define EKG_TRACE_POLL_DUMP(path, frame_count) ekg::trace::poll_dump(path, frame_count)
+#else
+#define EKG_TRACE_SCOPE(name)
+#define EKG_TRACE_FRAME(frame, image_indices, window_count)
+#define EKG_TRACE_INSTALL_SIGNAL()
+#define EKG_TRACE_REQUEST_DUMP()
+#define EKG_TRACE_POLL_DUMP(path, frame_count)
+#endif
+
+#ifdef EKG_TRACE
+namespace ekg::trace {
+    uint64_t now_ns();
+    void record(const char *name, uint64_t begin_ns, uint64_t end_ns);
+
+    struct scope {
+        const char *name {};
+        uint64_t begin_ns {};
+
+        explicit scope(const char *zone_name) : name(zone_name), begin_ns(ekg::trace::now_ns()) {}
+        ~scope() { ekg::trace::record(this->name, this->begin_ns, ekg::trace::now_ns()); }
+    };
+
+    /* One image index per window (up to 8), UINT32_MAX for a window that did not acquire this frame. */
+    void frame_mark(uint64_t frame, const uint32_t *image_indices, uint32_t window_count);
+
+    /* SIGUSR1 only requests the dump, it is written by the next `poll_dump()` out of the handler. */
+    void install_signal();
+    void request_dump();
+    bool poll_dump(std::string_view path, uint32_t frame_count);
+    bool dump(std::string_view path, uint32_t frame_count);
+}
+#endif
+
+#endif
@@ -0,0 +1,25 @@
+#version 450
+
+layout (set = 0, binding = 0) uniform sampler2D source;
+
+layout (push_constant) uniform blur_constants {
+    vec2 direction;
+};
+
+layout (location = 0) in vec2 in_uv;
+layout (location = 0) out vec4 out_color;
+
+/* Half of a 9 taps gaussian, the weights sum to 1 so a zero direction is a copy. */
+const float weights[5] = float[](0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+
+void main() {
+    vec2 texel = direction / vec2(textureSize(source, 0));
+    vec4 color = texture(source, in_uv) * weights[0];
+
+    for (int it = 1; it < 5; it++) {
+        color += texture(source, in_uv + texel * float(it)) * weights[it];
+        color += texture(source, in_uv - texel * float(it)) * weights[it];
+    }
+
+    out_color = color;
+}
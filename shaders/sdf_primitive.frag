@@ -0,0 +1,59 @@
+#version 450
+
+/* Must match `ekg::gpu::sdf_kind_*`. */
+const uint sdf_kind_rect = 0u;
+const uint sdf_kind_rounded_rect = 1u;
+const uint sdf_kind_circle = 2u;
+const uint sdf_kind_border = 3u;
+const uint sdf_kind_shadow = 4u;
+
+layout (location = 0) in vec2 in_local;
+layout (location = 1) flat in vec2 in_half_size;
+layout (location = 2) flat in vec3 in_shape;
+layout (location = 3) flat in uint in_kind;
+layout (location = 4) flat in vec4 in_fill_color;
+layout (location = 5) flat in vec4 in_border_color;
+
+layout (location = 0) out vec4 out_color;
+
+float sd_rounded_rect(vec2 p, vec2 half_size, float radius) {
+    vec2 q = abs(p) - half_size + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+/* Analytic coverage of the pixel footprint, replaces MSAA for the edges. */
+float coverage(float distance) {
+    return clamp(0.5 - distance / max(fwidth(distance), 0.0001), 0.0, 1.0);
+}
+
+void main() {
+    float radius = 0.0;
+    switch (in_kind) {
+        case sdf_kind_rect: radius = 0.0; break;
+        case sdf_kind_circle: radius = min(in_half_size.x, in_half_size.y); break;
+        default: radius = min(in_shape.x, min(in_half_size.x, in_half_size.y)); break;
+    }
+
+    float distance = sd_rounded_rect(in_local, in_half_size, radius);
+    vec4 color = in_fill_color;
+
+    if (in_kind == sdf_kind_shadow) {
+        float softness = max(in_shape.z, 0.0001);
+        color.a *= 1.0 - smoothstep(-softness, softness, distance);
+    } else {
+        float border_width = in_shape.y;
+        vec4 inside = in_kind == sdf_kind_border ? vec4(in_border_color.rgb, 0.0) : in_fill_color;
+
+        if (border_width > 0.0) {
+            color = mix(in_border_color, inside, coverage(distance + border_width));
+        }
+
+        color.a *= coverage(distance);
+    }
+
+    if (color.a <= 0.0) {
+        discard;
+    }
+
+    out_color = color;
+}
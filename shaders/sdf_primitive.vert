@@ -0,0 +1,35 @@
+#version 450
+
+/* One instance per primitive, a 4 vertices strip covers the rect plus its shadow and anti-aliasing margin. */
+layout (location = 0) in vec4 in_rect;
+layout (location = 1) in vec3 in_shape;
+layout (location = 2) in uint in_kind;
+layout (location = 3) in vec4 in_fill_color;
+layout (location = 4) in vec4 in_border_color;
+
+layout (push_constant) uniform sdf_constants {
+    vec2 viewport;
+};
+
+layout (location = 0) out vec2 out_local;
+layout (location = 1) flat out vec2 out_half_size;
+layout (location = 2) flat out vec3 out_shape;
+layout (location = 3) flat out uint out_kind;
+layout (location = 4) flat out vec4 out_fill_color;
+layout (location = 5) flat out vec4 out_border_color;
+
+void main() {
+    vec2 corner = vec2(float(gl_VertexIndex & 1), float(gl_VertexIndex >> 1));
+    vec2 half_size = in_rect.zw * 0.5;
+    float margin = in_shape.z + 1.0;
+
+    vec2 local = (corner * 2.0 - 1.0) * (half_size + margin);
+    gl_Position = vec4((in_rect.xy + half_size + local) / viewport * 2.0 - 1.0, 0.0, 1.0);
+
+    out_local = local;
+    out_half_size = half_size;
+    out_shape = in_shape;
+    out_kind = in_kind;
+    out_fill_color = in_fill_color;
+    out_border_color = in_border_color;
+}
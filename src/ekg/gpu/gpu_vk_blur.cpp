@@ -0,0 +1,162 @@
+#include "ekg/gpu/gpu_vk_blur.hpp"
+#include "ekg/gpu/gpu_vk_renderer.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/env.hpp"
+#include "ekg/util/trace.hpp"
+
+/* Descriptor sets per pool, a new pool is created when the last one is full. */
+constexpr uint32_t blur_sets_per_pool {16};
+
+bool ekg::gpu::blur_renderer::load_shaders(std::string_view vertex_shader_path, std::string_view fragment_shader_path) {
+    this->pipeline.vertex_bindings.clear();
+    this->pipeline.vertex_attributes.clear();
+    this->pipeline.cull_mode = VK_CULL_MODE_NONE;
+
+    return ekg::load_pipeline_shaders(this->pipeline, vertex_shader_path, fragment_shader_path);
+}
+
+bool ekg::gpu::blur_renderer::init() {
+    EKG_TRACE_SCOPE("create blur renderer");
+
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    VkSamplerCreateInfo sampler_info {};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    if (vkCreateSampler(vulkan.vk_device, &sampler_info, callbacks, &this->vk_sampler) != VK_SUCCESS) {
+        ekg::log("failed to create blur sampler!");
+        return false;
+    }
+
+    VkDescriptorSetLayoutBinding binding {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(vulkan.vk_device, &layout_info, callbacks, &this->vk_descriptor_set_layout) != VK_SUCCESS) {
+        ekg::log("failed to create blur descriptor set layout!");
+        return false;
+    }
+
+    VkPushConstantRange push_constant_range {};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push_constant_range.size = sizeof(float) * 2;
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &this->vk_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(vulkan.vk_device, &pipeline_layout_info, callbacks, &this->vk_pipeline_layout) != VK_SUCCESS) {
+        ekg::log("failed to create blur pipeline layout!");
+        return false;
+    }
+
+    this->pipeline.layout = this->vk_pipeline_layout;
+    return ekg::create_pipeline(this->pipeline);
+}
+
+void ekg::gpu::blur_renderer::destroy() {
+    VkDevice device {ekg::gpu::vulkan.vk_device};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    vkDestroyPipeline(device, this->pipeline.pipeline_info, callbacks);
+    vkDestroyPipelineLayout(device, this->vk_pipeline_layout, callbacks);
+
+    for (VkDescriptorPool &descriptor_pool : this->descriptor_pools) {
+        vkDestroyDescriptorPool(device, descriptor_pool, callbacks);
+    }
+
+    vkDestroyDescriptorSetLayout(device, this->vk_descriptor_set_layout, callbacks);
+    vkDestroySampler(device, this->vk_sampler, callbacks);
+    *this = {};
+}
+
+bool ekg::gpu::blur_renderer::add_source(uint32_t &source) {
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+
+    if (this->source_sets.size() % blur_sets_per_pool == 0) {
+        VkDescriptorPoolSize pool_size {};
+        pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        pool_size.descriptorCount = blur_sets_per_pool;
+
+        VkDescriptorPoolCreateInfo pool_info {};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.maxSets = blur_sets_per_pool;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &pool_size;
+
+        if (vkCreateDescriptorPool(vulkan.vk_device, &pool_info, ekg::gpu::host.get_callbacks(), &this->descriptor_pools.emplace_back()) != VK_SUCCESS) {
+            this->descriptor_pools.pop_back();
+            ekg::log("failed to create blur descriptor pool!");
+            return false;
+        }
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = this->descriptor_pools.back();
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &this->vk_descriptor_set_layout;
+
+    VkDescriptorSet descriptor_set {};
+    if (vkAllocateDescriptorSets(vulkan.vk_device, &allocate_info, &descriptor_set) != VK_SUCCESS) {
+        ekg::log("failed to allocate blur descriptor set!");
+        return false;
+    }
+
+    source = static_cast<uint32_t>(this->source_sets.size());
+    this->source_sets.push_back(descriptor_set);
+    return true;
+}
+
+void ekg::gpu::blur_renderer::set_source(uint32_t source, VkImageView view) {
+    if (source >= this->source_sets.size() || view == VK_NULL_HANDLE) {
+        return;
+    }
+
+    VkDescriptorImageInfo image_info {};
+    image_info.sampler = this->vk_sampler;
+    image_info.imageView = view;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = this->source_sets[source];
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_info;
+
+    vkUpdateDescriptorSets(ekg::gpu::vulkan.vk_device, 1, &write, 0, nullptr);
+}
+
+void ekg::gpu::blur_renderer::draw(VkCommandBuffer command_buffer, uint32_t source, float direction_x, float direction_y) {
+    EKG_TRACE_SCOPE("blur draw");
+
+    if (source >= this->source_sets.size()) {
+        return;
+    }
+
+    float constants[2] {direction_x, direction_y};
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.pipeline_info);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vk_pipeline_layout, 0, 1, &this->source_sets[source], 0, nullptr);
+    vkCmdPushConstants(command_buffer, this->vk_pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), constants);
+    vkCmdDraw(command_buffer, 3, 1, 0, 0);
+}
@@ -0,0 +1,258 @@
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/env.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+ekg::gpu::host_allocator ekg::gpu::host {};
+
+namespace {
+    /* Written right before every pointer handed to the driver. */
+    struct block_header {
+        void *origin {};
+        size_t size {};
+        uint32_t scope {};
+        bool from_arena {};
+    };
+
+    constexpr size_t header_size {(sizeof(block_header) + 15) & ~static_cast<size_t>(15)};
+    constexpr const char *scope_names[ekg::gpu::host_allocation_scope_count] {"command", "object", "cache", "device", "instance"};
+
+    uintptr_t align_up(uintptr_t address, size_t alignment) {
+        return (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    }
+
+    block_header *get_header(void *memory) {
+        return reinterpret_cast<block_header*>(static_cast<char*>(memory) - sizeof(block_header));
+    }
+}
+
+void ekg::gpu::host_allocator::init(size_t arena_size) {
+    this->arena.resize(arena_size);
+    this->arena_offset = 0;
+
+    this->callbacks.pUserData = this;
+    this->callbacks.pfnAllocation = &ekg::gpu::host_allocator::allocation;
+    this->callbacks.pfnReallocation = &ekg::gpu::host_allocator::reallocation;
+    this->callbacks.pfnFree = &ekg::gpu::host_allocator::free;
+    this->callbacks.pfnInternalAllocation = &ekg::gpu::host_allocator::internal_allocation;
+    this->callbacks.pfnInternalFree = &ekg::gpu::host_allocator::internal_free;
+}
+
+const VkAllocationCallbacks *ekg::gpu::host_allocator::get_callbacks() {
+    return this->callbacks.pfnAllocation != nullptr ? &this->callbacks : nullptr;
+}
+
+void *ekg::gpu::host_allocator::alloc_heap(size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    alignment = std::max(alignment, alignof(std::max_align_t));
+
+    char *origin {static_cast<char*>(std::malloc(size + alignment + header_size))};
+    if (origin == nullptr) {
+        return nullptr;
+    }
+
+    char *memory {reinterpret_cast<char*>(align_up(reinterpret_cast<uintptr_t>(origin + header_size), alignment))};
+    *get_header(memory) = {origin, size, static_cast<uint32_t>(scope), false};
+
+    this->heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    this->live_bytes.fetch_add(size, std::memory_order_relaxed);
+    return memory;
+}
+
+void *ekg::gpu::host_allocator::alloc_arena(size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    alignment = std::max(alignment, alignof(std::max_align_t));
+
+    uintptr_t base {reinterpret_cast<uintptr_t>(this->arena.data())};
+    size_t begin {this->arena_offset.load(std::memory_order_relaxed)};
+    size_t end {};
+    uintptr_t memory {};
+
+    do {
+        memory = align_up(base + begin + header_size, alignment);
+        end = (memory - base) + size;
+
+        if (end > this->arena.size()) {
+            this->arena_overflows.fetch_add(1, std::memory_order_relaxed);
+            return this->alloc_heap(size, alignment, scope);
+        }
+    } while (!this->arena_offset.compare_exchange_weak(begin, end, std::memory_order_relaxed));
+
+    *get_header(reinterpret_cast<void*>(memory)) = {nullptr, size, static_cast<uint32_t>(scope), true};
+    this->arena_allocations.fetch_add(1, std::memory_order_relaxed);
+    return reinterpret_cast<void*>(memory);
+}
+
+void *ekg::gpu::host_allocator::allocation(void *user_data, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    auto *allocator {static_cast<ekg::gpu::host_allocator*>(user_data)};
+    if (size == 0) {
+        return nullptr;
+    }
+
+    allocator->allocations[scope].fetch_add(1, std::memory_order_relaxed);
+    allocator->bytes[scope].fetch_add(size, std::memory_order_relaxed);
+
+    if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && !allocator->arena.empty()) {
+        return allocator->alloc_arena(size, alignment, scope);
+    }
+
+    return allocator->alloc_heap(size, alignment, scope);
+}
+
+void *ekg::gpu::host_allocator::reallocation(void *user_data, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    if (original == nullptr) {
+        return ekg::gpu::host_allocator::allocation(user_data, size, alignment, scope);
+    }
+
+    if (size == 0) {
+        ekg::gpu::host_allocator::free(user_data, original);
+        return nullptr;
+    }
+
+    void *memory {ekg::gpu::host_allocator::allocation(user_data, size, alignment, scope)};
+    if (memory != nullptr) {
+        std::memcpy(memory, original, std::min(size, get_header(original)->size));
+        ekg::gpu::host_allocator::free(user_data, original);
+    }
+
+    return memory;
+}
+
+void ekg::gpu::host_allocator::free(void *user_data, void *memory) {
+    if (memory == nullptr) {
+        return;
+    }
+
+    auto *allocator {static_cast<ekg::gpu::host_allocator*>(user_data)};
+    block_header *header {get_header(memory)};
+
+    /* Arena blocks are released all at once by `begin_frame()`. */
+    if (!header->from_arena) {
+        allocator->live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+        std::free(header->origin);
+    }
+}
+
+void ekg::gpu::host_allocator::internal_allocation(void *user_data, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope) {
+    auto *allocator {static_cast<ekg::gpu::host_allocator*>(user_data)};
+    allocator->internal_allocations[scope].fetch_add(1, std::memory_order_relaxed);
+    allocator->live_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void ekg::gpu::host_allocator::internal_free(void *user_data, size_t size, VkInternalAllocationType, VkSystemAllocationScope) {
+    auto *allocator {static_cast<ekg::gpu::host_allocator*>(user_data)};
+    allocator->live_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+ekg::gpu::host_allocation_stats ekg::gpu::host_allocator::get_stats() {
+    ekg::gpu::host_allocation_stats stats {};
+
+    for (uint32_t it {}; it < ekg::gpu::host_allocation_scope_count; it++) {
+        stats.allocations[it] = this->allocations[it].load(std::memory_order_relaxed);
+        stats.bytes[it] = this->bytes[it].load(std::memory_order_relaxed);
+        stats.internal_allocations[it] = this->internal_allocations[it].load(std::memory_order_relaxed);
+    }
+
+    stats.heap_allocations = this->heap_allocations.load(std::memory_order_relaxed);
+    stats.arena_allocations = this->arena_allocations.load(std::memory_order_relaxed);
+    stats.arena_overflows = this->arena_overflows.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ekg::gpu::host_allocator::begin_frame() {
+    this->arena_offset.store(0, std::memory_order_relaxed);
+    this->frame_begin_stats = this->get_stats();
+}
+
+void ekg::gpu::host_allocator::end_frame() {
+    ekg::gpu::host_allocation_stats stats {this->get_stats()};
+    ekg::gpu::host_allocation_stats &begin {this->frame_begin_stats};
+
+    for (uint32_t it {}; it < ekg::gpu::host_allocation_scope_count; it++) {
+        this->frame_stats.allocations[it] = stats.allocations[it] - begin.allocations[it];
+        this->frame_stats.bytes[it] = stats.bytes[it] - begin.bytes[it];
+        this->frame_stats.internal_allocations[it] = stats.internal_allocations[it] - begin.internal_allocations[it];
+    }
+
+    this->frame_stats.heap_allocations = stats.heap_allocations - begin.heap_allocations;
+    this->frame_stats.arena_allocations = stats.arena_allocations - begin.arena_allocations;
+    this->frame_stats.arena_overflows = stats.arena_overflows - begin.arena_overflows;
+
+    if (this->strict_steady_state && this->frame_stats.heap_allocations != 0) {
+        ekg::log("host allocator: " + std::to_string(this->frame_stats.heap_allocations) + " heap allocations in a steady state frame!");
+        this->report_frame();
+    }
+
+    this->interval_frames++;
+    this->interval_heap_frames += this->frame_stats.heap_allocations != 0;
+    this->interval_heap_allocations += this->frame_stats.heap_allocations;
+    this->interval_worst_heap_allocations = std::max(this->interval_worst_heap_allocations, this->frame_stats.heap_allocations);
+
+    if (this->report_interval_frames != 0 && this->interval_frames >= this->report_interval_frames) {
+        char buffer[192] {};
+        std::snprintf(buffer, sizeof(buffer), "host allocator: %llu of the last %llu frames touched the heap (%llu heap allocations, worst frame %llu)",
+                      static_cast<unsigned long long>(this->interval_heap_frames),
+                      static_cast<unsigned long long>(this->interval_frames),
+                      static_cast<unsigned long long>(this->interval_heap_allocations),
+                      static_cast<unsigned long long>(this->interval_worst_heap_allocations));
+        ekg::log(buffer);
+
+        this->interval_frames = 0;
+        this->interval_heap_frames = 0;
+        this->interval_heap_allocations = 0;
+        this->interval_worst_heap_allocations = 0;
+    }
+}
+
+void ekg::gpu::host_allocator::report_frame() {
+    char buffer[192] {};
+
+    for (uint32_t it {}; it < ekg::gpu::host_allocation_scope_count; it++) {
+        if (this->frame_stats.allocations[it] == 0 && this->frame_stats.internal_allocations[it] == 0) {
+            continue;
+        }
+
+        std::snprintf(buffer, sizeof(buffer), "host allocator: frame %-8s %6llu allocations %10llu bytes, %llu internal",
+                      scope_names[it],
+                      static_cast<unsigned long long>(this->frame_stats.allocations[it]),
+                      static_cast<unsigned long long>(this->frame_stats.bytes[it]),
+                      static_cast<unsigned long long>(this->frame_stats.internal_allocations[it]));
+        ekg::log(buffer);
+    }
+
+    std::snprintf(buffer, sizeof(buffer), "host allocator: frame %llu heap, %llu arena (%llu overflows)",
+                  static_cast<unsigned long long>(this->frame_stats.heap_allocations),
+                  static_cast<unsigned long long>(this->frame_stats.arena_allocations),
+                  static_cast<unsigned long long>(this->frame_stats.arena_overflows));
+    ekg::log(buffer);
+}
+
+ekg::gpu::host_allocation_stats &ekg::gpu::host_allocator::get_frame_stats() {
+    return this->frame_stats;
+}
+
+uint64_t ekg::gpu::host_allocator::get_live_bytes() {
+    return this->live_bytes.load(std::memory_order_relaxed);
+}
+
+void ekg::gpu::host_allocator::report() {
+    ekg::gpu::host_allocation_stats stats {this->get_stats()};
+    char buffer[256] {};
+
+    for (uint32_t it {}; it < ekg::gpu::host_allocation_scope_count; it++) {
+        std::snprintf(buffer, sizeof(buffer), "host allocator: %-8s %8llu allocations %12llu bytes (last frame %llu allocations), %llu internal",
+                      scope_names[it],
+                      static_cast<unsigned long long>(stats.allocations[it]),
+                      static_cast<unsigned long long>(stats.bytes[it]),
+                      static_cast<unsigned long long>(this->frame_stats.allocations[it]),
+                      static_cast<unsigned long long>(stats.internal_allocations[it]));
+        ekg::log(buffer);
+    }
+
+    std::snprintf(buffer, sizeof(buffer), "host allocator: %llu heap, %llu arena (%llu overflows), %llu live bytes",
+                  static_cast<unsigned long long>(stats.heap_allocations),
+                  static_cast<unsigned long long>(stats.arena_allocations),
+                  static_cast<unsigned long long>(stats.arena_overflows),
+                  static_cast<unsigned long long>(this->get_live_bytes()));
+    ekg::log(buffer);
+}
@@ -1,29 +1,52 @@
 #include "ekg/gpu/gpu_vk_pipeline.hpp"
 #include "ekg/util/env.hpp"
 #include "ekg/gpu/gpu_vk_renderer.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/trace.hpp"
+
+bool ekg::load_pipeline_shaders(ekg::gpu::pipeline &pipeline, std::string_view vertex_shader_path, std::string_view fragment_shader_path) {
+    pipeline.vertex_shader_code.clear();
+    pipeline.fragment_shader_code.clear();
+
+    if (!ekg::read_file(vertex_shader_path, pipeline.vertex_shader_code) || !ekg::read_file(fragment_shader_path, pipeline.fragment_shader_code)) {
+        ekg::log("failed to read pipeline shaders!");
+        return false;
+    }
+
+    return true;
+}
 
 bool ekg::create_pipeline(ekg::gpu::pipeline &pipeline, std::string_view vertex_shader_path, std::string_view fragment_shader_path) {
-    std::string vertex_shader_source {};
-    std::string fragment_shader_source {};
+    return ekg::load_pipeline_shaders(pipeline, vertex_shader_path, fragment_shader_path) && ekg::create_pipeline(pipeline);
+}
+
+bool ekg::create_pipeline(ekg::gpu::pipeline &pipeline) {
+    EKG_TRACE_SCOPE("create pipeline");
+
+    /* Built against `vk_render_pass`, a sample count its attachment does not have is invalid usage. */
+    if (pipeline.samples != ekg::gpu::vulkan.vk_render_pass_samples) {
+        ekg::log("pipeline sample count differs from the render pass one!");
+        return false;
+    }
 
     VkShaderModule vertex_shader_module {};
     VkShaderModule fragment_shader_module {};
 
-    bool flag {ekg::read_file(vertex_shader_path, vertex_shader_source) && ekg::read_file(fragment_shader_path, fragment_shader_source)};
-    flag = flag && ekg::gpu::vulkan.create_shader_module(vertex_shader_module, vertex_shader_source) && ekg::gpu::vulkan.create_shader_module(fragment_shader_module, fragment_shader_source);
-
+    bool flag {ekg::gpu::vulkan.create_shader_module(vertex_shader_module, pipeline.vertex_shader_code) && ekg::gpu::vulkan.create_shader_module(fragment_shader_module, pipeline.fragment_shader_code)};
     if (!flag) {
         return false;
     }
 
     VkPipelineVertexInputStateCreateInfo vertex_input_state_info {};
     vertex_input_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertex_input_state_info.vertexBindingDescriptionCount = 0;
-    vertex_input_state_info.vertexAttributeDescriptionCount = 0;
+    vertex_input_state_info.vertexBindingDescriptionCount = static_cast<uint32_t>(pipeline.vertex_bindings.size());
+    vertex_input_state_info.pVertexBindingDescriptions = pipeline.vertex_bindings.data();
+    vertex_input_state_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(pipeline.vertex_attributes.size());
+    vertex_input_state_info.pVertexAttributeDescriptions = pipeline.vertex_attributes.data();
 
     VkPipelineInputAssemblyStateCreateInfo input_assembly {};
-    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.topology = pipeline.topology;
     input_assembly.primitiveRestartEnable = VK_FALSE;
 
     VkPipelineViewportStateCreateInfo viewport_state {};
@@ -37,18 +60,24 @@ bool ekg::create_pipeline(ekg::gpu::pipeline &pipeline, std::string_view vertex_
     rasterizer.rasterizerDiscardEnable = VK_FALSE;
     rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
     rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizer.cullMode = pipeline.cull_mode;
     rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
     rasterizer.depthBiasEnable = VK_FALSE;
 
     VkPipelineMultisampleStateCreateInfo multisampling {};
     multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.rasterizationSamples = pipeline.samples;
 
     VkPipelineColorBlendAttachmentState color_blend_attachment {};
     color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    color_blend_attachment.blendEnable = VK_FALSE;
+    color_blend_attachment.blendEnable = pipeline.alpha_blend ? VK_TRUE : VK_FALSE;
+    color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
 
     VkPipelineColorBlendStateCreateInfo color_blending {};
     color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -94,18 +123,22 @@ bool ekg::create_pipeline(ekg::gpu::pipeline &pipeline, std::string_view vertex_
     pipeline_info.pMultisampleState = &multisampling;
     pipeline_info.pColorBlendState = &color_blending;
     pipeline_info.pDynamicState = &dynamic_state;
-    pipeline_info.layout = ekg::gpu::vulkan.vk_pipeline_layout;
+    pipeline_info.layout = pipeline.layout != VK_NULL_HANDLE ? pipeline.layout : ekg::gpu::vulkan.vk_pipeline_layout;
     pipeline_info.renderPass = ekg::gpu::vulkan.vk_render_pass;
     pipeline_info.subpass = 0;
     pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(ekg::gpu::vulkan.vk_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline.pipeline_info) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(ekg::gpu::vulkan.vk_device, ekg::gpu::vulkan.vk_pipeline_cache, 1, &pipeline_info, ekg::gpu::host.get_callbacks(), &pipeline.pipeline_info) != VK_SUCCESS) {
         ekg::log("failed to create graphics pipeline!");
         return false;
     }
 
-    vkDestroyShaderModule(ekg::gpu::vulkan.vk_device, vertex_shader_module, nullptr);
-    vkDestroyShaderModule(ekg::gpu::vulkan.vk_device, fragment_shader_module, nullptr);
+    vkDestroyShaderModule(ekg::gpu::vulkan.vk_device, vertex_shader_module, ekg::gpu::host.get_callbacks());
+    vkDestroyShaderModule(ekg::gpu::vulkan.vk_device, fragment_shader_module, ekg::gpu::host.get_callbacks());
+
+    /* The SPIR-V is now owned by the driver, keep no copy in host memory. */
+    pipeline.vertex_shader_code = {};
+    pipeline.fragment_shader_code = {};
 
     return true;
 }
@@ -0,0 +1,678 @@
+#include "ekg/gpu/gpu_vk_render_graph.hpp"
+#include "ekg/gpu/gpu_vk_renderer.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/env.hpp"
+#include "ekg/util/trace.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    struct access_info {
+        VkPipelineStageFlags stage {};
+        VkAccessFlags access {};
+        VkImageLayout layout {};
+        VkImageUsageFlags usage {};
+        bool write {};
+        bool attachment {};
+    };
+
+    access_info get_access_info(uint32_t access) {
+        switch (access) {
+            case ekg::gpu::access_color_attachment_write: {
+                return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true, true};
+            }
+
+            case ekg::gpu::access_color_attachment_read_write: {
+                return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true, true};
+            }
+
+            case ekg::gpu::access_sampled: {
+                return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false, false};
+            }
+
+            case ekg::gpu::access_transfer_read: {
+                return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false, false};
+            }
+
+            default: {
+                return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true, false};
+            }
+        }
+    }
+}
+
+VkRenderPass ekg::gpu::render_pass_cache::get_render_pass(const std::vector<ekg::gpu::render_pass_attachment> &attachments) {
+    std::vector<uint32_t> key {};
+    key.reserve(attachments.size() * 5);
+
+    for (const ekg::gpu::render_pass_attachment &attachment : attachments) {
+        key.insert(key.end(), {
+            static_cast<uint32_t>(attachment.format), static_cast<uint32_t>(attachment.samples),
+            static_cast<uint32_t>(attachment.load_op), static_cast<uint32_t>(attachment.store_op),
+            static_cast<uint32_t>(attachment.layout)
+        });
+    }
+
+    auto cached {this->render_passes.find(key)};
+    if (cached != this->render_passes.end()) {
+        return cached->second;
+    }
+
+    EKG_TRACE_SCOPE("create render pass");
+
+    std::vector<VkAttachmentDescription> descriptions(attachments.size());
+    std::vector<VkAttachmentReference> references(attachments.size());
+
+    for (uint32_t it {}; it < attachments.size(); it++) {
+        VkAttachmentDescription &description {descriptions[it]};
+        description.format = attachments[it].format;
+        description.samples = attachments[it].samples;
+        description.loadOp = attachments[it].load_op;
+        description.storeOp = attachments[it].store_op;
+        description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.initialLayout = attachments[it].layout;
+        description.finalLayout = attachments[it].layout;
+
+        references[it].attachment = it;
+        references[it].layout = attachments[it].layout;
+    }
+
+    VkSubpassDescription subpass {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(references.size());
+    subpass.pColorAttachments = references.data();
+
+    /*
+     * Layouts never change inside the pass, the render graph barrier recorded right before
+     * `vkCmdBeginRenderPass` transitions them; the external dependency orders the attachment
+     * access against any earlier attachment output on the queue.
+     */
+    VkSubpassDependency dependency {};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo render_pass_info {};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_info.attachmentCount = static_cast<uint32_t>(descriptions.size());
+    render_pass_info.pAttachments = descriptions.data();
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+    render_pass_info.dependencyCount = 1;
+    render_pass_info.pDependencies = &dependency;
+
+    VkRenderPass render_pass {};
+    if (vkCreateRenderPass(ekg::gpu::vulkan.vk_device, &render_pass_info, ekg::gpu::host.get_callbacks(), &render_pass) != VK_SUCCESS) {
+        ekg::log("failed to create render pass!");
+        return VK_NULL_HANDLE;
+    }
+
+    this->render_passes[key] = render_pass;
+    return render_pass;
+}
+
+VkFramebuffer ekg::gpu::render_pass_cache::get_framebuffer(VkRenderPass render_pass, const std::vector<VkImageView> &views, VkExtent2D extent) {
+    /* Reused key storage, a hit costs no heap allocation in a steady state frame. */
+    this->framebuffer_key.clear();
+    this->framebuffer_key.push_back(reinterpret_cast<uint64_t>(render_pass));
+    this->framebuffer_key.push_back((static_cast<uint64_t>(extent.width) << 32) | extent.height);
+
+    for (VkImageView view : views) {
+        this->framebuffer_key.push_back(reinterpret_cast<uint64_t>(view));
+    }
+
+    auto cached {this->framebuffers.find(this->framebuffer_key)};
+    if (cached != this->framebuffers.end()) {
+        return cached->second;
+    }
+
+    EKG_TRACE_SCOPE("create framebuffer");
+
+    VkFramebufferCreateInfo framebuffer_info {};
+    framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebuffer_info.renderPass = render_pass;
+    framebuffer_info.attachmentCount = static_cast<uint32_t>(views.size());
+    framebuffer_info.pAttachments = views.data();
+    framebuffer_info.width = extent.width;
+    framebuffer_info.height = extent.height;
+    framebuffer_info.layers = 1;
+
+    VkFramebuffer framebuffer {};
+    if (vkCreateFramebuffer(ekg::gpu::vulkan.vk_device, &framebuffer_info, ekg::gpu::host.get_callbacks(), &framebuffer) != VK_SUCCESS) {
+        ekg::log("failed to create framebuffer!");
+        return VK_NULL_HANDLE;
+    }
+
+    this->framebuffers[this->framebuffer_key] = framebuffer;
+    return framebuffer;
+}
+
+void ekg::gpu::render_pass_cache::clear_framebuffers() {
+    for (auto &[key, framebuffer] : this->framebuffers) {
+        vkDestroyFramebuffer(ekg::gpu::vulkan.vk_device, framebuffer, ekg::gpu::host.get_callbacks());
+    }
+
+    this->framebuffers.clear();
+}
+
+void ekg::gpu::render_pass_cache::clear_framebuffers(const std::vector<VkImageView> &views) {
+    for (auto it {this->framebuffers.begin()}; it != this->framebuffers.end();) {
+        /* The key is render pass, extent, then the views. */
+        bool uses_view {};
+        for (size_t key_index {2}; key_index < it->first.size() && !uses_view; key_index++) {
+            uses_view = std::find(views.begin(), views.end(), reinterpret_cast<VkImageView>(it->first[key_index])) != views.end();
+        }
+
+        if (!uses_view) {
+            ++it;
+            continue;
+        }
+
+        vkDestroyFramebuffer(ekg::gpu::vulkan.vk_device, it->second, ekg::gpu::host.get_callbacks());
+        it = this->framebuffers.erase(it);
+    }
+}
+
+void ekg::gpu::render_pass_cache::destroy() {
+    this->clear_framebuffers();
+
+    for (auto &[key, render_pass] : this->render_passes) {
+        vkDestroyRenderPass(ekg::gpu::vulkan.vk_device, render_pass, ekg::gpu::host.get_callbacks());
+    }
+
+    this->render_passes.clear();
+}
+
+void ekg::gpu::render_graph::set_cache(ekg::gpu::render_pass_cache *render_pass_cache) {
+    this->cache = render_pass_cache;
+}
+
+uint32_t ekg::gpu::render_graph::import_image(std::string_view tag, VkFormat format, VkExtent2D extent, VkPipelineStageFlags ready_stage, VkImageLayout final_layout) {
+    ekg::gpu::render_graph_resource &resource {this->resources.emplace_back()};
+    resource.tag = tag;
+    resource.format = format;
+    resource.extent = extent;
+    resource.imported = true;
+    resource.imported_stage = ready_stage;
+    resource.final_layout = final_layout;
+
+    this->compiled = false;
+    return static_cast<uint32_t>(this->resources.size() - 1);
+}
+
+uint32_t ekg::gpu::render_graph::create_image(std::string_view tag, VkFormat format, VkExtent2D extent) {
+    ekg::gpu::render_graph_resource &resource {this->resources.emplace_back()};
+    resource.tag = tag;
+    resource.format = format;
+    resource.extent = extent;
+    resource.relative = extent.width == 0 || extent.height == 0;
+
+    this->compiled = false;
+    return static_cast<uint32_t>(this->resources.size() - 1);
+}
+
+void ekg::gpu::render_graph::set_extent(uint32_t resource, VkExtent2D extent) {
+    this->resources[resource].extent = extent;
+    this->compiled = false;
+}
+
+void ekg::gpu::render_graph::set_image(uint32_t resource, VkImage image, VkImageView view) {
+    this->resources[resource].image = image;
+    this->resources[resource].view = view;
+}
+
+VkImageView ekg::gpu::render_graph::get_view(uint32_t resource) {
+    return this->resources[resource].view;
+}
+
+void ekg::gpu::render_graph::add_pass(std::string_view tag, const std::vector<ekg::gpu::render_graph_access> &accesses, const std::function<void(VkCommandBuffer)> &record, bool clear, VkClearColorValue clear_color) {
+    ekg::gpu::render_graph_pass &pass {this->passes.emplace_back()};
+    pass.tag = tag;
+    pass.accesses = accesses;
+    pass.record = record;
+    pass.clear = clear;
+    pass.clear_color = clear_color;
+
+    this->compiled = false;
+}
+
+bool ekg::gpu::render_graph::allocate_transients() {
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    std::vector<VkMemoryRequirements> requirements(this->resources.size());
+    std::vector<uint32_t> transients {};
+
+    for (uint32_t it {}; it < this->resources.size(); it++) {
+        ekg::gpu::render_graph_resource &resource {this->resources[it]};
+        if (resource.imported || resource.usage == 0) {
+            continue;
+        }
+
+        VkImageCreateInfo image_info {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = resource.format;
+        image_info.extent = {resource.extent.width, resource.extent.height, 1};
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = resource.usage | (resource.attachment_only ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(vulkan.vk_device, &image_info, callbacks, &resource.image) != VK_SUCCESS) {
+            ekg::log("render graph: failed to create transient image '" + resource.tag + "'");
+            return false;
+        }
+
+        vkGetImageMemoryRequirements(vulkan.vk_device, resource.image, &requirements[it]);
+
+        /* Tiled GPUs can keep attachment-only images in tile memory and never back them. */
+        uint32_t memory_type_index {};
+        resource.lazily_allocated = resource.attachment_only && vulkan.find_memory_type(memory_type_index, requirements[it].memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+        transients.push_back(it);
+    }
+
+    /* Biggest first, each image joins the first block where no tenant overlaps its lifetime. */
+    std::sort(transients.begin(), transients.end(), [&requirements](uint32_t a, uint32_t b) {
+        return requirements[a].size > requirements[b].size;
+    });
+
+    for (uint32_t it : transients) {
+        ekg::gpu::render_graph_resource &resource {this->resources[it]};
+        resource.memory_block = static_cast<uint32_t>(this->memory_blocks.size());
+
+        for (uint32_t block_index {}; block_index < this->memory_blocks.size(); block_index++) {
+            ekg::gpu::render_graph_memory_block &block {this->memory_blocks[block_index]};
+            if (block.lazily_allocated != resource.lazily_allocated || (block.memory_type_bits & requirements[it].memoryTypeBits) == 0) {
+                continue;
+            }
+
+            bool overlaps {};
+            for (uint32_t tenant : block.resources) {
+                overlaps = overlaps || !(resource.last_pass < this->resources[tenant].first_pass || this->resources[tenant].last_pass < resource.first_pass);
+            }
+
+            if (!overlaps) {
+                resource.memory_block = block_index;
+                break;
+            }
+        }
+
+        if (resource.memory_block == this->memory_blocks.size()) {
+            this->memory_blocks.emplace_back().lazily_allocated = resource.lazily_allocated;
+        }
+
+        ekg::gpu::render_graph_memory_block &block {this->memory_blocks[resource.memory_block]};
+        block.size = std::max(block.size, requirements[it].size);
+        block.memory_type_bits &= requirements[it].memoryTypeBits;
+        block.resources.push_back(it);
+    }
+
+    for (ekg::gpu::render_graph_memory_block &block : this->memory_blocks) {
+        VkMemoryAllocateInfo allocate_info {};
+        allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocate_info.allocationSize = block.size;
+
+        VkMemoryPropertyFlags properties {block.lazily_allocated ? VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+        if (!vulkan.find_memory_type(allocate_info.memoryTypeIndex, block.memory_type_bits, properties)) {
+            ekg::log("render graph: failed to find suitable memory type!");
+            return false;
+        }
+
+        if (vkAllocateMemory(vulkan.vk_device, &allocate_info, callbacks, &block.memory) != VK_SUCCESS) {
+            ekg::log("render graph: failed to allocate transient memory!");
+            return false;
+        }
+
+        for (uint32_t tenant : block.resources) {
+            ekg::gpu::render_graph_resource &resource {this->resources[tenant]};
+            vkBindImageMemory(vulkan.vk_device, resource.image, block.memory, 0);
+
+            VkImageViewCreateInfo view_info {};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = resource.image;
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = resource.format;
+            view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(vulkan.vk_device, &view_info, callbacks, &resource.view) != VK_SUCCESS) {
+                ekg::log("render graph: failed to create transient image view '" + resource.tag + "'");
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ekg::gpu::render_graph::plan_barriers() {
+    struct state {
+        VkPipelineStageFlags stage {};
+        VkAccessFlags access {};
+        VkImageLayout layout {VK_IMAGE_LAYOUT_UNDEFINED};
+        bool written {};
+        bool touched {};
+    };
+
+    std::vector<state> states(this->resources.size());
+    std::vector<state> block_states(this->memory_blocks.size());
+    this->batches.assign(this->passes.size() + 1, {});
+
+    for (uint32_t it {}; it < this->resources.size(); it++) {
+        states[it].stage = this->resources[it].imported_stage;
+    }
+
+    for (uint32_t pass_index {}; pass_index < this->passes.size(); pass_index++) {
+        ekg::gpu::render_graph_barrier_batch &batch {this->batches[pass_index]};
+
+        for (const ekg::gpu::render_graph_access &access : this->passes[pass_index].accesses) {
+            ekg::gpu::render_graph_resource &resource {this->resources[access.resource]};
+            state &current {states[access.resource]};
+            access_info info {get_access_info(access.access)};
+
+            if (!resource.imported && !current.touched) {
+                /* First use of a transient: the contents are undefined, only the previous tenant of the memory must be done. */
+                state &block {block_states[resource.memory_block]};
+                batch.transitions.push_back({access.resource, block.access, info.access, VK_IMAGE_LAYOUT_UNDEFINED, info.layout});
+                batch.src_stage |= block.stage;
+            } else if (current.layout != info.layout || current.written || info.write) {
+                batch.transitions.push_back({access.resource, current.access, info.access, current.layout, info.layout});
+                batch.src_stage |= current.stage;
+            } else {
+                /* Read after read in the same layout, no barrier, but the next writer waits for this reader too. */
+                current.stage |= info.stage;
+                current.access |= info.access;
+
+                if (!resource.imported) {
+                    block_states[resource.memory_block] = current;
+                }
+
+                continue;
+            }
+
+            batch.dst_stage |= info.stage;
+            current = {info.stage, info.access, info.layout, info.write, true};
+
+            if (!resource.imported) {
+                block_states[resource.memory_block] = current;
+            }
+        }
+    }
+
+    ekg::gpu::render_graph_barrier_batch &final_batch {this->batches.back()};
+    for (uint32_t it {}; it < this->resources.size(); it++) {
+        ekg::gpu::render_graph_resource &resource {this->resources[it]};
+
+        if (resource.imported && resource.final_layout != VK_IMAGE_LAYOUT_UNDEFINED && resource.final_layout != states[it].layout) {
+            final_batch.transitions.push_back({it, states[it].access, 0, states[it].layout, resource.final_layout});
+            final_batch.src_stage |= states[it].stage;
+            final_batch.dst_stage |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        }
+    }
+}
+
+bool ekg::gpu::render_graph::compile() {
+    EKG_TRACE_SCOPE("compile render graph");
+
+    if (this->cache == nullptr) {
+        ekg::log("render graph: no render pass cache set");
+        return false;
+    }
+
+    this->destroy();
+
+    VkExtent2D imported_extent {};
+    for (ekg::gpu::render_graph_resource &resource : this->resources) {
+        if (resource.imported) {
+            imported_extent = resource.extent;
+            break;
+        }
+    }
+
+    for (ekg::gpu::render_graph_resource &resource : this->resources) {
+        if (resource.relative) {
+            resource.extent = imported_extent;
+        }
+
+        if (!resource.imported && (resource.extent.width == 0 || resource.extent.height == 0)) {
+            ekg::log("render graph: transient image '" + resource.tag + "' has no extent");
+            return false;
+        }
+
+        resource.usage = 0;
+        resource.attachment_only = true;
+        resource.first_pass = std::numeric_limits<uint32_t>::max();
+        resource.last_pass = 0;
+    }
+
+    for (uint32_t pass_index {}; pass_index < this->passes.size(); pass_index++) {
+        ekg::gpu::render_graph_pass &pass {this->passes[pass_index]};
+        pass.color_attachments.clear();
+
+        for (const ekg::gpu::render_graph_access &access : pass.accesses) {
+            if (access.resource >= this->resources.size()) {
+                ekg::log("render graph: pass '" + pass.tag + "' accesses an unknown resource");
+                return false;
+            }
+
+            ekg::gpu::render_graph_resource &resource {this->resources[access.resource]};
+            access_info info {get_access_info(access.access)};
+
+            if (resource.first_pass != std::numeric_limits<uint32_t>::max() && resource.last_pass == pass_index) {
+                ekg::log("render graph: pass '" + pass.tag + "' accesses '" + resource.tag + "' twice");
+                return false;
+            }
+
+            resource.usage |= info.usage;
+            resource.attachment_only = resource.attachment_only && info.attachment;
+            resource.first_pass = std::min(resource.first_pass, pass_index);
+            resource.last_pass = pass_index;
+
+            if (info.attachment) {
+                pass.color_attachments.push_back(access.resource);
+            }
+        }
+    }
+
+    if (!this->allocate_transients()) {
+        return false;
+    }
+
+    this->plan_barriers();
+
+    size_t max_attachments {};
+    size_t max_transitions {};
+    uint32_t barrier_calls {};
+    uint32_t image_barriers {};
+
+    for (uint32_t pass_index {}; pass_index < this->passes.size(); pass_index++) {
+        ekg::gpu::render_graph_pass &pass {this->passes[pass_index]};
+        pass.render_pass = VK_NULL_HANDLE;
+
+        if (pass.color_attachments.empty()) {
+            continue;
+        }
+
+        std::vector<ekg::gpu::render_pass_attachment> attachments {};
+        pass.extent = this->resources[pass.color_attachments.front()].extent;
+
+        for (const ekg::gpu::render_graph_access &access : pass.accesses) {
+            ekg::gpu::render_graph_resource &resource {this->resources[access.resource]};
+            if (!get_access_info(access.access).attachment) {
+                continue;
+            }
+
+            ekg::gpu::render_pass_attachment &attachment {attachments.emplace_back()};
+            attachment.format = resource.format;
+            attachment.load_op = access.access == ekg::gpu::access_color_attachment_read_write ? VK_ATTACHMENT_LOAD_OP_LOAD : (pass.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+            attachment.store_op = resource.imported || resource.last_pass > pass_index ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+            if (resource.extent.width != pass.extent.width || resource.extent.height != pass.extent.height) {
+                ekg::log("render graph: pass '" + pass.tag + "' attachments differ in extent");
+                return false;
+            }
+        }
+
+        pass.render_pass = this->cache->get_render_pass(attachments);
+        max_attachments = std::max(max_attachments, attachments.size());
+    }
+
+    for (ekg::gpu::render_graph_barrier_batch &batch : this->batches) {
+        max_transitions = std::max(max_transitions, batch.transitions.size());
+        barrier_calls += !batch.transitions.empty();
+        image_barriers += static_cast<uint32_t>(batch.transitions.size());
+    }
+
+    /* Sized once, so `execute()` stays allocation free. */
+    this->image_barriers.reserve(max_transitions);
+    this->attachment_views.reserve(max_attachments);
+    this->clear_values.reserve(max_attachments);
+
+    uint32_t lazily_allocated {};
+    for (ekg::gpu::render_graph_memory_block &block : this->memory_blocks) {
+        lazily_allocated += block.lazily_allocated;
+    }
+
+    uint32_t transient_count {};
+    for (ekg::gpu::render_graph_resource &resource : this->resources) {
+        transient_count += !resource.imported && resource.image != VK_NULL_HANDLE;
+    }
+
+    /* Recompiled on every resize, only the first compile is logged. */
+    if (!this->reported) {
+        this->reported = true;
+        ekg::log("render graph: " + std::to_string(this->passes.size()) + " passes, " + std::to_string(barrier_calls) + " barrier calls (" + std::to_string(image_barriers) + " image barriers), " +
+                 std::to_string(transient_count) + " transient images in " + std::to_string(this->memory_blocks.size()) + " memory blocks (" + std::to_string(lazily_allocated) + " lazily allocated)");
+    }
+
+    this->compiled = true;
+    if (this->on_compiled) this->on_compiled(*this);
+    return true;
+}
+
+void ekg::gpu::render_graph::emit(VkCommandBuffer command_buffer, const ekg::gpu::render_graph_barrier_batch &batch) {
+    if (batch.transitions.empty()) {
+        return;
+    }
+
+    this->image_barriers.clear();
+
+    for (const ekg::gpu::render_graph_transition &transition : batch.transitions) {
+        VkImageMemoryBarrier &barrier {this->image_barriers.emplace_back()};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = transition.src_access;
+        barrier.dstAccessMask = transition.dst_access;
+        barrier.oldLayout = transition.old_layout;
+        barrier.newLayout = transition.new_layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = this->resources[transition.resource].image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+    }
+
+    vkCmdPipelineBarrier(command_buffer,
+                         batch.src_stage ? batch.src_stage : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+                         batch.dst_stage ? batch.dst_stage : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT),
+                         0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(this->image_barriers.size()), this->image_barriers.data());
+}
+
+bool ekg::gpu::render_graph::execute(VkCommandBuffer command_buffer) {
+    if (!this->compiled) {
+        ekg::log("render graph: executed before compile");
+        return false;
+    }
+
+    for (uint32_t pass_index {}; pass_index < this->passes.size(); pass_index++) {
+        ekg::gpu::render_graph_pass &pass {this->passes[pass_index]};
+        this->emit(command_buffer, this->batches[pass_index]);
+
+        if (pass.render_pass == VK_NULL_HANDLE) {
+            if (pass.record) pass.record(command_buffer);
+            continue;
+        }
+
+        this->attachment_views.clear();
+        this->clear_values.clear();
+
+        for (uint32_t resource : pass.color_attachments) {
+            this->attachment_views.push_back(this->resources[resource].view);
+            this->clear_values.emplace_back().color = pass.clear_color;
+        }
+
+        VkRenderPassBeginInfo render_pass_info {};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_info.renderPass = pass.render_pass;
+        render_pass_info.framebuffer = this->cache->get_framebuffer(pass.render_pass, this->attachment_views, pass.extent);
+        render_pass_info.renderArea.extent = pass.extent;
+        render_pass_info.clearValueCount = static_cast<uint32_t>(this->clear_values.size());
+        render_pass_info.pClearValues = this->clear_values.data();
+
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport {};
+        viewport.width = static_cast<float>(pass.extent.width);
+        viewport.height = static_cast<float>(pass.extent.height);
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+        VkRect2D scissor {};
+        scissor.extent = pass.extent;
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+        if (pass.record) pass.record(command_buffer);
+        vkCmdEndRenderPass(command_buffer);
+    }
+
+    this->emit(command_buffer, this->batches.back());
+    return true;
+}
+
+void ekg::gpu::render_graph::destroy() {
+    VkDevice device {ekg::gpu::vulkan.vk_device};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    this->attachment_views.clear();
+    for (ekg::gpu::render_graph_resource &resource : this->resources) {
+        if (!resource.imported && resource.image != VK_NULL_HANDLE) {
+            this->attachment_views.push_back(resource.view);
+        }
+    }
+
+    /*
+     * A new view may reuse a destroyed handle, so no framebuffer built over the old ones can stay cached;
+     * only this graph's are dropped, other windows may already have recorded theirs this frame.
+     */
+    if (!this->attachment_views.empty() && this->cache != nullptr) {
+        this->cache->clear_framebuffers(this->attachment_views);
+    }
+
+    for (ekg::gpu::render_graph_resource &resource : this->resources) {
+        if (resource.imported || resource.image == VK_NULL_HANDLE) {
+            continue;
+        }
+
+        vkDestroyImageView(device, resource.view, callbacks);
+        vkDestroyImage(device, resource.image, callbacks);
+        resource.view = VK_NULL_HANDLE;
+        resource.image = VK_NULL_HANDLE;
+    }
+
+    for (ekg::gpu::render_graph_memory_block &block : this->memory_blocks) {
+        vkFreeMemory(device, block.memory, callbacks);
+    }
+
+    this->memory_blocks.clear();
+    this->batches.clear();
+    this->compiled = false;
+}
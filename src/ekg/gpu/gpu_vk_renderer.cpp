@@ -1,5 +1,7 @@
 #include "ekg/gpu/gpu_vk_renderer.hpp"
 #include "ekg/util/env.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/trace.hpp"
 #include <vulkan/vulkan.h>
 #include <SDL2/SDL_vulkan.h>
 #include <set>
@@ -12,15 +14,39 @@ bool ekg::gpu::queue_families::is_complete() {
     return graphics_family.has_value() && present_family.has_value();
 }
 
-std::vector<const char*> &ekg::gpu::vk_renderer::get_extensions() {
+ekg::gpu::vk_window *ekg::gpu::vk_renderer::add_window(SDL_Window *sdl_window) {
+    ekg::gpu::vk_window &window {*this->windows.emplace_back(std::make_unique<ekg::gpu::vk_window>())};
+    window.sdl_window = sdl_window;
+
+    if (this->vk_device == VK_NULL_HANDLE) {
+        return &window;
+    }
+
+    if (!(window.create_surface() && window.create_swap_chain() && window.create_image_views() && window.create_sync_objects() && window.create_render_graph() &&
+          (!this->build_render_graph || this->build_render_graph(window)))) {
+        ekg::log("failed to create window!");
+        window.destroy();
+        this->windows.pop_back();
+        return nullptr;
+    }
+
+    this->reserve_frame_lists();
+    return &window;
+}
+
+std::vector<const char*> ekg::gpu::vk_renderer::get_extensions() {
+    /* Surface extensions do not depend on the window, the first one answers for all. */
+    SDL_Window *sdl_window {this->windows.front()->sdl_window};
     uint32_t extension_counts {};
-    SDL_Vulkan_GetInstanceExtensions(this->sdl_window, &extension_counts, nullptr);
+    SDL_Vulkan_GetInstanceExtensions(sdl_window, &extension_counts, nullptr);
     std::vector<const char*> extensions {extension_counts};
-    SDL_Vulkan_GetInstanceExtensions(this->sdl_window, &extension_counts, extensions.data());
+    SDL_Vulkan_GetInstanceExtensions(sdl_window, &extension_counts, extensions.data());
     return extensions;
 }
 
-void ekg::gpu::vk_renderer::create_instance() {
+bool ekg::gpu::vk_renderer::create_instance() {
+    EKG_TRACE_SCOPE("create instance");
+
     VkApplicationInfo vk_app_info {};
     vk_app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     vk_app_info.pApplicationName = "vk ekg test";
@@ -42,15 +68,18 @@ void ekg::gpu::vk_renderer::create_instance() {
         create_info.enabledLayerCount = static_cast<uint32_t>(this->validation_layers.size());
         create_info.ppEnabledLayerNames = this->validation_layers.data();
         this->populate_debug_messenger_create_info(debug_info);
-        create_info.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &create_info;
+        create_info.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debug_info;
     } else {
         create_info.enabledLayerCount = 0;
         create_info.pNext = nullptr;
     }
 
-    if (vkCreateInstance(&create_info, nullptr, &this->vk_instance) != VK_SUCCESS) {
+    if (vkCreateInstance(&create_info, ekg::gpu::host.get_callbacks(), &this->vk_instance) != VK_SUCCESS) {
         ekg::log("failed to create vulkan instance.");
+        return false;
     }
+
+    return true;
 }
 
 void ekg::gpu::vk_renderer::populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT &create_info) {
@@ -66,26 +95,98 @@ VkBool32 ekg::gpu::vk_renderer::debug_callback(VkDebugUtilsMessageSeverityFlagBi
     return 0;
 }
 
-void ekg::gpu::vk_renderer::setup() {
-    this->create_instance();
-    this->setup_debug_messenger();
-    this->pick_physical_device();
-    this->create_logical_device();
-    this->create_swap_chain();
-    this->create_image_views();
-    this->create_render_pass();
-    this->create_graphics_pipeline();
+bool ekg::gpu::vk_renderer::setup() {
+    ekg::gpu::host.init();
+
+    if (this->windows.empty()) {
+        ekg::log("no window added before renderer setup!");
+        return false;
+    }
+
+    /* SDL window calls (instance extensions, surfaces, drawable size) stay on the calling thread. */
+    this->startup.add("instance", [this]() { return this->create_instance(); }, {}, true);
+    this->startup.add("debug messenger", [this]() { return this->setup_debug_messenger(); }, {"instance"});
+    this->startup.add("surface", [this]() { return this->create_surfaces(); }, {"instance"}, true);
+    this->startup.add("physical device", [this]() { return this->pick_physical_device(); }, {"surface"});
+    this->startup.add("logical device", [this]() { return this->create_logical_device(); }, {"physical device"});
+    this->startup.add("swap chain", [this]() { return this->create_swap_chains(); }, {"logical device"}, true);
+    this->startup.add("image views", [this]() { return this->create_image_views(); }, {"swap chain"});
+    this->startup.add("render pass", [this]() { return this->create_render_pass(); }, {"swap chain"});
+    this->startup.add("pipeline layout", [this]() { return this->create_graphics_pipeline(); }, {"logical device"});
+    this->startup.add("render graph", [this]() { return this->create_render_graphs(); }, {"image views"});
+    this->startup.add("command buffers", [this]() { return this->create_command_buffers(); }, {"logical device"});
+    this->startup.add("sync objects", [this]() { return this->create_sync_objects(); }, {"logical device"});
+
+    bool succeeded {this->startup.run(this->startup_thread_count)};
+    this->startup.report("startup");
+
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        succeeded = succeeded && (!this->build_render_graph || this->build_render_graph(*window));
+    }
+
+    if (!succeeded) {
+        ekg::log("failed to run startup graph!");
+    }
+
+    this->startup.clear();
+    return succeeded;
 }
 
-void ekg::gpu::vk_renderer::setup_debug_messenger() {
-    if (!this->enable_validation_layers) return;
+void ekg::gpu::vk_renderer::quit() {
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    /* A failed `setup()` may stop at any phase, only what was created is destroyed. */
+    if (this->vk_device != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(this->vk_device);
+
+        vkDestroySemaphore(this->vk_device, this->vk_render_finished_semaphore, callbacks);
+        vkDestroyFence(this->vk_device, this->vk_in_flight_fence, callbacks);
+        vkDestroyCommandPool(this->vk_device, this->vk_command_pool, callbacks);
+
+        /* Framebuffers go before the swap chain views they were built over. */
+        this->render_pass_cache.clear_framebuffers();
+    }
+
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        window->destroy();
+    }
+
+    this->windows.clear();
+
+    if (this->vk_device != VK_NULL_HANDLE) {
+        this->render_pass_cache.destroy();
+
+        vkDestroyPipelineLayout(this->vk_device, this->vk_pipeline_layout, callbacks);
+        vkDestroyPipelineCache(this->vk_device, this->vk_pipeline_cache, callbacks);
+        vkDestroyDevice(this->vk_device, callbacks);
+        this->vk_device = VK_NULL_HANDLE;
+    }
+
+    if (this->vk_instance == VK_NULL_HANDLE) {
+        return;
+    }
+
+    if (this->enable_validation_layers) {
+        auto func = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(this->vk_instance, "vkDestroyDebugUtilsMessengerEXT");
+        if (func != nullptr) func(this->vk_instance, this->vk_debug_messenger, callbacks);
+    }
+
+    vkDestroyInstance(this->vk_instance, callbacks);
+    this->vk_instance = VK_NULL_HANDLE;
+}
+
+bool ekg::gpu::vk_renderer::setup_debug_messenger() {
+    if (!this->enable_validation_layers) return true;
 
     VkDebugUtilsMessengerCreateInfoEXT create_info {};
     this->populate_debug_messenger_create_info(create_info);
 
-    if (CreateDebugUtilsMessengerEXT(this->vk_instance, &create_info, nullptr, &this->vk_debug_messenger) != VK_SUCCESS) {
+    if (CreateDebugUtilsMessengerEXT(this->vk_instance, &create_info, ekg::gpu::host.get_callbacks(), &this->vk_debug_messenger) != VK_SUCCESS) {
         ekg::log("failed to set up debug messenger!");
+        return false;
     }
+
+    return true;
 }
 
 VkResult ekg::gpu::vk_renderer::CreateDebugUtilsMessengerEXT(VkInstance &instance, const VkDebugUtilsMessengerCreateInfoEXT *create_info, const VkAllocationCallbacks *allocator, VkDebugUtilsMessengerEXT *debug_messenger) {
@@ -97,18 +198,23 @@ VkResult ekg::gpu::vk_renderer::CreateDebugUtilsMessengerEXT(VkInstance &instanc
     }
 }
 
-void ekg::gpu::vk_renderer::create_surface() {
-    if (SDL_Vulkan_CreateSurface(this->sdl_window, this->vk_instance, &this->vk_surface)) {
-        ekg::log("could not create vulkan surface!!");
+bool ekg::gpu::vk_renderer::create_surfaces() {
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        if (!window->create_surface()) return false;
     }
+
+    return true;
 }
 
-void ekg::gpu::vk_renderer::pick_physical_device() {
+bool ekg::gpu::vk_renderer::pick_physical_device() {
+    EKG_TRACE_SCOPE("pick physical device");
+
     uint32_t device_count {};
     vkEnumeratePhysicalDevices(this->vk_instance, &device_count, nullptr);
 
-    if (device_count != 0) {
+    if (device_count == 0) {
         ekg::log("failed to find GPUs with Vulkan support!");
+        return false;
     }
 
     std::vector<VkPhysicalDevice> devices(device_count);
@@ -123,7 +229,10 @@ void ekg::gpu::vk_renderer::pick_physical_device() {
 
     if (this->vk_physical_device == VK_NULL_HANDLE) {
         ekg::log("failed to find a suitable GPU!");
+        return false;
     }
+
+    return true;
 }
 
 bool ekg::gpu::vk_renderer::is_device_suitable(VkPhysicalDevice device) {
@@ -135,7 +244,7 @@ bool ekg::gpu::vk_renderer::is_device_suitable(VkPhysicalDevice device) {
 
     if (extensions_supported) {
         ekg::gpu::swap_chain_support_details details {};
-        this->query_swap_chain_support(details, device);
+        this->query_swap_chain_support(details, device, this->windows.front()->vk_surface);
         swap_chain_adequate = !details.formats.empty() && !details.present_modes.empty();
     }
 
@@ -150,12 +259,13 @@ void ekg::gpu::vk_renderer::find_queue_families(ekg::gpu::queue_families &indice
 
     int32_t i {};
     for (const auto &queue_family : queue_families) {
-        if (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        /* The spec guarantees one family with both when graphics exists, compute dispatches share the graphics queue. */
+        if ((queue_family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) {
             indices.graphics_family = i;
         }
 
         VkBool32 present_support {};
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, this->vk_surface, &present_support);
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, this->windows.front()->vk_surface, &present_support);
 
         if (present_support) {
             indices.present_family = i;
@@ -185,27 +295,29 @@ bool ekg::gpu::vk_renderer::check_device_extension_support(VkPhysicalDevice &dev
     return required_extensions.empty();
 }
 
-void ekg::gpu::vk_renderer::query_swap_chain_support(ekg::gpu::swap_chain_support_details &details, VkPhysicalDevice &device) {
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, this->vk_surface, &details.capabilities);
+void ekg::gpu::vk_renderer::query_swap_chain_support(ekg::gpu::swap_chain_support_details &details, VkPhysicalDevice &device, VkSurfaceKHR surface) {
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
 
     uint32_t format_count {};
-    vkGetPhysicalDeviceSurfaceFormatsKHR(device, this->vk_surface, &format_count, nullptr);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, nullptr);
 
     if (format_count != 0) {
         details.formats.resize(format_count);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(device, this->vk_surface, &format_count, details.formats.data());
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, details.formats.data());
     }
 
     uint32_t present_mode_count {};
-    vkGetPhysicalDeviceSurfacePresentModesKHR(device, this->vk_surface, &present_mode_count, nullptr);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, nullptr);
 
     if (present_mode_count != 0) {
         details.present_modes.resize(present_mode_count);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(device, this->vk_surface, &present_mode_count, details.present_modes.data());
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, details.present_modes.data());
     }
 }
 
-void ekg::gpu::vk_renderer::create_logical_device() {
+bool ekg::gpu::vk_renderer::create_logical_device() {
+    EKG_TRACE_SCOPE("create logical device");
+
     ekg::gpu::queue_families indices {};
     this->find_queue_families(indices, this->vk_physical_device);
 
@@ -215,7 +327,7 @@ void ekg::gpu::vk_renderer::create_logical_device() {
     float queue_priority {1.0f};
     for (uint32_t queue_family : unique_queue_families) {
         VkDeviceQueueCreateInfo queue_create_info {};
-        queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queue_create_info.queueFamilyIndex = queue_family;
         queue_create_info.queueCount = 1;
         queue_create_info.pQueuePriorities = &queue_priority;
@@ -241,183 +353,363 @@ void ekg::gpu::vk_renderer::create_logical_device() {
         create_info.enabledLayerCount = 0;
     }
 
-    if (vkCreateDevice(this->vk_physical_device, &create_info, nullptr, &this->vk_device) != VK_SUCCESS) {
+    if (vkCreateDevice(this->vk_physical_device, &create_info, ekg::gpu::host.get_callbacks(), &this->vk_device) != VK_SUCCESS) {
         ekg::log("failed to create logical device!");
+        return false;
     }
 
     vkGetDeviceQueue(this->vk_device, indices.graphics_family.value(), 0, &vk_graphics_queue);
     vkGetDeviceQueue(this->vk_device, indices.present_family.value(), 0, &vk_present_queue);
+
+    /* One cache for every pipeline of every window, pipeline tasks may create through it concurrently. */
+    VkPipelineCacheCreateInfo pipeline_cache_info {};
+    pipeline_cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if (vkCreatePipelineCache(this->vk_device, &pipeline_cache_info, ekg::gpu::host.get_callbacks(), &this->vk_pipeline_cache) != VK_SUCCESS) {
+        ekg::log("failed to create pipeline cache!");
+        return false;
+    }
+
+    return true;
 }
 
-void ekg::gpu::vk_renderer::create_swap_chain() {
-    ekg::gpu::swap_chain_support_details support {};
-    this->query_swap_chain_support(support, this->vk_physical_device);
+bool ekg::gpu::vk_renderer::create_swap_chains() {
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        if (!window->create_swap_chain()) return false;
+    }
 
-    VkSurfaceFormatKHR surface_format {this->choose_swap_surface_format(support.formats)};
-    VkPresentModeKHR present_mode_format {this->choose_swap_present_mode_format(support.present_modes)};
-    VkExtent2D extent {choose_swap_extent(support.capabilities)};
+    return true;
+}
 
-    uint32_t image_count {};
-    if (support.capabilities.maxImageCount < 0 && image_count > support.capabilities.maxImageCount) {
-        image_count = support.capabilities.maxImageCount;
+bool ekg::gpu::vk_renderer::create_image_views() {
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        if (!window->create_image_views()) return false;
     }
 
-    VkSwapchainCreateInfoKHR create_info {};
-    create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    create_info.surface = this->vk_surface;
-    create_info.imageFormat = surface_format.format;
-    create_info.imageColorSpace = surface_format.colorSpace;
-    create_info.imageExtent = extent;
-    create_info.imageArrayLayers = 1;
-    create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    return true;
+}
 
-    ekg::gpu::queue_families indicies {};
-    this->find_queue_families(indicies, this->vk_physical_device);
-    uint32_t queue_family_indices[] = {indicies.graphics_family.value(), indicies.present_family.value()};
+bool ekg::gpu::vk_renderer::create_render_pass() {
+    ekg::gpu::render_pass_attachment color_attachment {};
+    color_attachment.format = this->windows.front()->vk_swap_chain_image_format;
+    color_attachment.samples = this->vk_render_pass_samples;
 
-    if (indicies.graphics_family != indicies.present_family) {
-        create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-        create_info.queueFamilyIndexCount = 2;
-        create_info.pQueueFamilyIndices = queue_family_indices;
-    } else {
-        create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    this->vk_render_pass = this->render_pass_cache.get_render_pass({color_attachment});
+    return this->vk_render_pass != VK_NULL_HANDLE;
+}
+
+bool ekg::gpu::vk_renderer::create_graphics_pipeline() {
+    EKG_TRACE_SCOPE("create pipeline layout");
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info {};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 0;
+    pipeline_layout_create_info.pushConstantRangeCount = 0;
+
+    if (vkCreatePipelineLayout(this->vk_device, &pipeline_layout_create_info, ekg::gpu::host.get_callbacks(), &this->vk_pipeline_layout) != VK_SUCCESS) {
+        ekg::log("failed to create pipeline layout!");
+        return false;
     }
 
-    create_info.preTransform = support.capabilities.currentTransform;
-    create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    create_info.presentMode = present_mode_format;
-    create_info.clipped = VK_TRUE;
-    create_info.oldSwapchain = VK_NULL_HANDLE;
+    return true;
+}
 
-    if (vkCreateSwapchainKHR(this->vk_device, &create_info, nullptr, &this->vk_swap_chain) != VK_SUCCESS) {
-        ekg::log("failed to create swap chain!");
+bool ekg::gpu::vk_renderer::create_render_graphs() {
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        if (!window->create_render_graph()) return false;
     }
 
-    vkGetSwapchainImagesKHR(this->vk_device, this->vk_swap_chain, &image_count, nullptr);
-    this->swap_chain_images.resize(image_count);
-    vkGetSwapchainImagesKHR(this->vk_device, this->vk_swap_chain, &image_count, this->swap_chain_images.data());
+    return true;
+}
+
+bool ekg::gpu::vk_renderer::create_command_buffers() {
+    EKG_TRACE_SCOPE("create command buffers");
 
-    this->vk_swap_chain_image_format = surface_format.format;
-    this->vk_swap_chain_extent = extent;
+    ekg::gpu::queue_families indices {};
+    this->find_queue_families(indices, this->vk_physical_device);
+
+    VkCommandPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = indices.graphics_family.value();
+
+    if (vkCreateCommandPool(this->vk_device, &pool_info, ekg::gpu::host.get_callbacks(), &this->vk_command_pool) != VK_SUCCESS) {
+        ekg::log("failed to create command pool!");
+        return false;
+    }
+
+    VkCommandBufferAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocate_info.commandPool = this->vk_command_pool;
+    allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate_info.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(this->vk_device, &allocate_info, &this->vk_command_buffer) != VK_SUCCESS) {
+        ekg::log("failed to allocate command buffer!");
+        return false;
+    }
+
+    return true;
 }
 
-VkSurfaceFormatKHR
-ekg::gpu::vk_renderer::choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR> &available_formats) {
-    for (const auto &available_format : available_formats) {
-        if (available_format.format == VK_FORMAT_B8G8R8A8_SRGB && available_format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-            return available_format;
-        }
+bool ekg::gpu::vk_renderer::create_sync_objects() {
+    EKG_TRACE_SCOPE("create sync objects");
+
+    VkSemaphoreCreateInfo semaphore_info {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fence_info {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    if (vkCreateSemaphore(this->vk_device, &semaphore_info, ekg::gpu::host.get_callbacks(), &this->vk_render_finished_semaphore) != VK_SUCCESS ||
+        vkCreateFence(this->vk_device, &fence_info, ekg::gpu::host.get_callbacks(), &this->vk_in_flight_fence) != VK_SUCCESS) {
+        ekg::log("failed to create sync objects!");
+        return false;
     }
 
-    return available_formats[0];
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        if (!window->create_sync_objects()) return false;
+    }
+
+    this->reserve_frame_lists();
+    return true;
+}
+
+void ekg::gpu::vk_renderer::reserve_frame_lists() {
+    this->wait_semaphores.reserve(this->windows.size());
+    this->wait_stages.reserve(this->windows.size());
+    this->present_swap_chains.reserve(this->windows.size());
+    this->present_image_indices.reserve(this->windows.size());
+    this->present_results.reserve(this->windows.size());
+    this->present_windows.reserve(this->windows.size());
 }
 
-VkPresentModeKHR
-ekg::gpu::vk_renderer::choose_swap_present_mode_format(const std::vector<VkPresentModeKHR> &available_present_modes) {
-    for (const auto &available_present_mode : available_present_modes) {
-        if (available_present_mode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            return available_present_mode;
+void ekg::gpu::vk_renderer::cancel_frame() {
+    this->wait_semaphores.clear();
+    this->wait_stages.clear();
+    this->present_windows.clear();
+
+    /* The acquired images can not be presented unrendered, recreating the swap chains takes them back. */
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        if (!window->acquired) {
+            continue;
         }
+
+        this->wait_semaphores.push_back(window->vk_image_available_semaphore);
+        this->wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        this->present_windows.push_back(window.get());
+        window->acquired = false;
+        window->out_of_date = true;
+    }
+
+    /* An empty batch unsignals the acquire semaphores and signals the fence `begin_frame()` reset. */
+    VkSubmitInfo submit_info {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.waitSemaphoreCount = static_cast<uint32_t>(this->wait_semaphores.size());
+    submit_info.pWaitSemaphores = this->wait_semaphores.data();
+    submit_info.pWaitDstStageMask = this->wait_stages.data();
+
+    if (vkQueueSubmit(this->vk_graphics_queue, 1, &submit_info, this->vk_in_flight_fence) == VK_SUCCESS) {
+        return;
+    }
+
+    /* Nothing unsignals the acquire semaphores nor signals the fence then, both are created again once the device is idle. */
+    ekg::log("failed to submit cancelled frame!");
+    vkDeviceWaitIdle(this->vk_device);
+
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+    for (ekg::gpu::vk_window *&window : this->present_windows) {
+        vkDestroySemaphore(this->vk_device, window->vk_image_available_semaphore, callbacks);
+        window->vk_image_available_semaphore = VK_NULL_HANDLE;
+        window->create_sync_objects();
     }
 
-    return available_present_modes[0];
+    VkFenceCreateInfo fence_info {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    vkDestroyFence(this->vk_device, this->vk_in_flight_fence, callbacks);
+    this->vk_in_flight_fence = VK_NULL_HANDLE;
+
+    if (vkCreateFence(this->vk_device, &fence_info, callbacks, &this->vk_in_flight_fence) != VK_SUCCESS) {
+        ekg::log("failed to create in flight fence!");
+    }
 }
 
-VkExtent2D ekg::gpu::vk_renderer::choose_swap_extent(const VkSurfaceCapabilitiesKHR &capabilities) {
-    if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-        return capabilities.currentExtent;
-    } else {
-        int32_t framebuffer_w {}, framebuffer_h {};
-        SDL_Vulkan_GetDrawableSize(this->sdl_window, &framebuffer_w, &framebuffer_h);
-
-        VkExtent2D actual_extent {
-            static_cast<uint32_t>(framebuffer_w),
-            static_cast<uint32_t>(framebuffer_h)
-        };
-
-        actual_extent.width = std::clamp(actual_extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
-        actual_extent.height = std::clamp(actual_extent.height, capabilities.minImageExtent.width, capabilities.maxImageExtent.height);
-
-        return actual_extent;
-    }
-}
-
-void ekg::gpu::vk_renderer::create_image_views() {
-    this->swap_chain_image_view.resize(this->swap_chain_image_view.size());
-
-    for (size_t i = 0; i < this->swap_chain_images.size(); i++) {
-        VkImageViewCreateInfo create_info {};
-        create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        create_info.image = this->swap_chain_images[i];
-        create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        create_info.format = this->vk_swap_chain_image_format;
-        create_info.components.r = VK_COMPONENT_SWIZZLE_R;
-        create_info.components.g = VK_COMPONENT_SWIZZLE_G;
-        create_info.components.b = VK_COMPONENT_SWIZZLE_B;
-        create_info.components.a = VK_COMPONENT_SWIZZLE_A;
-        create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        create_info.subresourceRange.baseMipLevel = 0;
-        create_info.subresourceRange.levelCount = 1;
-        create_info.subresourceRange.baseArrayLayer = 0;
-        create_info.subresourceRange.layerCount = 1;
-
-        if (vkCreateImageView(this->vk_device, &create_info, nullptr, &this->swap_chain_image_view[i]) != VK_SUCCESS) {
-            ekg::log("failed to create image views!");
+ekg::gpu::vk_window *ekg::gpu::vk_renderer::find_window(uint32_t sdl_window_id) {
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        if (SDL_GetWindowID(window->sdl_window) == sdl_window_id) {
+            return window.get();
         }
     }
+
+    return nullptr;
 }
 
-void ekg::gpu::vk_renderer::create_render_pass() {
-    VkAttachmentDescription color_attachment {};
-    color_attachment.format = this->vk_swap_chain_image_format;
-    color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+VkCommandBuffer ekg::gpu::vk_renderer::begin_frame() {
+    EKG_TRACE_SCOPE("acquire");
 
-    VkAttachmentReference color_attachment_ref {};
-    color_attachment_ref.attachment = 0;
-    color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    vkWaitForFences(this->vk_device, 1, &this->vk_in_flight_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
 
-    VkSubpassDescription subpass {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &color_attachment_ref;
+    bool any_acquired {};
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        any_acquired = window->acquire() || any_acquired;
+    }
+
+    /* The fence stays signaled, nothing is submitted this frame. */
+    if (!any_acquired) {
+        return VK_NULL_HANDLE;
+    }
 
-    VkRenderPassCreateInfo render_pass_info {};
-    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    render_pass_info.attachmentCount = 1;
-    render_pass_info.pAttachments = &color_attachment;
-    render_pass_info.subpassCount = 1;
-    render_pass_info.pSubpasses = &subpass;
+    vkResetFences(this->vk_device, 1, &this->vk_in_flight_fence);
+    vkResetCommandBuffer(this->vk_command_buffer, 0);
 
-    if (vkCreateRenderPass(this->vk_device, &render_pass_info, nullptr, &this->vk_render_pass)) {
-        ekg::log("failed to create render pass!");
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(this->vk_command_buffer, &begin_info) != VK_SUCCESS) {
+        ekg::log("failed to begin recording command buffer!");
+        this->cancel_frame();
+        return VK_NULL_HANDLE;
     }
+
+    return this->vk_command_buffer;
 }
 
-void ekg::gpu::vk_renderer::create_graphics_pipeline() {
-    VkPipelineLayoutCreateInfo pipeline_layout_create_info {};
-    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_create_info.setLayoutCount = 0;
-    pipeline_layout_create_info.pushConstantRangeCount = 0;
+void ekg::gpu::vk_renderer::end_frame() {
+    EKG_TRACE_SCOPE("submit and present");
 
-    if (vkCreatePipelineLayout(this->vk_device, &pipeline_layout_create_info, nullptr, &this->vk_pipeline_layout) != VK_SUCCESS) {
-        ekg::log("failed to create pipeline layout!");
+    if (vkEndCommandBuffer(this->vk_command_buffer) != VK_SUCCESS) {
+        ekg::log("failed to record command buffer!");
+        this->cancel_frame();
+        return;
     }
+
+    this->wait_semaphores.clear();
+    this->wait_stages.clear();
+    this->present_swap_chains.clear();
+    this->present_image_indices.clear();
+    this->present_windows.clear();
+
+    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->windows) {
+        if (!window->acquired) {
+            continue;
+        }
+
+        this->wait_semaphores.push_back(window->vk_image_available_semaphore);
+        this->wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        this->present_swap_chains.push_back(window->vk_swap_chain);
+        this->present_image_indices.push_back(window->current_image_index);
+        this->present_windows.push_back(window.get());
+    }
+
+    VkSubmitInfo submit_info {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.waitSemaphoreCount = static_cast<uint32_t>(this->wait_semaphores.size());
+    submit_info.pWaitSemaphores = this->wait_semaphores.data();
+    submit_info.pWaitDstStageMask = this->wait_stages.data();
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &this->vk_command_buffer;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &this->vk_render_finished_semaphore;
+
+    /* Left unsubmitted, the fence `begin_frame()` waits on would never be signaled. */
+    if (vkQueueSubmit(this->vk_graphics_queue, 1, &submit_info, this->vk_in_flight_fence) != VK_SUCCESS) {
+        ekg::log("failed to submit draw command buffer!");
+        this->cancel_frame();
+        return;
+    }
+
+    for (ekg::gpu::vk_window *&window : this->present_windows) {
+        window->acquired = false;
+    }
+
+    VkPresentInfoKHR present_info {};
+    present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    present_info.waitSemaphoreCount = 1;
+    present_info.pWaitSemaphores = &this->vk_render_finished_semaphore;
+    present_info.swapchainCount = static_cast<uint32_t>(this->present_swap_chains.size());
+    present_info.pSwapchains = this->present_swap_chains.data();
+    present_info.pImageIndices = this->present_image_indices.data();
+
+    this->present_results.resize(this->present_swap_chains.size());
+    present_info.pResults = this->present_results.data();
+
+    vkQueuePresentKHR(this->vk_present_queue, &present_info);
+
+    for (size_t it {}; it < this->present_results.size(); it++) {
+        VkResult result {this->present_results[it]};
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            this->present_windows[it]->out_of_date = true;
+        } else if (result != VK_SUCCESS) {
+            ekg::log("failed to present swap chain image!");
+        }
+    }
+}
+
+bool ekg::gpu::vk_renderer::find_memory_type(uint32_t &memory_type_index, uint32_t type_filter, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memory_properties {};
+    vkGetPhysicalDeviceMemoryProperties(this->vk_physical_device, &memory_properties);
+
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+        if ((type_filter & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
+            memory_type_index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ekg::gpu::vk_renderer::create_buffer(VkBuffer &buffer, VkDeviceMemory &buffer_memory, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(this->vk_device, &buffer_info, ekg::gpu::host.get_callbacks(), &buffer) != VK_SUCCESS) {
+        ekg::log("failed to create buffer!");
+        return false;
+    }
+
+    VkMemoryRequirements memory_requirements {};
+    vkGetBufferMemoryRequirements(this->vk_device, buffer, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+
+    if (!this->find_memory_type(allocate_info.memoryTypeIndex, memory_requirements.memoryTypeBits, properties)) {
+        ekg::log("failed to find suitable memory type!");
+        return false;
+    }
+
+    if (vkAllocateMemory(this->vk_device, &allocate_info, ekg::gpu::host.get_callbacks(), &buffer_memory) != VK_SUCCESS) {
+        ekg::log("failed to allocate buffer memory!");
+        return false;
+    }
+
+    vkBindBufferMemory(this->vk_device, buffer, buffer_memory, 0);
+    return true;
 }
 
-bool ekg::gpu::vk_renderer::create_shader_module(VkShaderModule &shader_module, const std::string &code) {
+bool ekg::gpu::vk_renderer::create_shader_module(VkShaderModule &shader_module, const std::vector<char> &code) {
+    if (code.empty()) {
+        ekg::log("failed to create shader module, no code!");
+        return false;
+    }
+
     VkShaderModuleCreateInfo create_info {};
 
     create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     create_info.codeSize = code.size();
     create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
-    if (vkCreateShaderModule(this->vk_device, &create_info, nullptr, &shader_module) != VK_SUCCESS) {
+    if (vkCreateShaderModule(this->vk_device, &create_info, ekg::gpu::host.get_callbacks(), &shader_module) != VK_SUCCESS) {
         return false;
     }
 
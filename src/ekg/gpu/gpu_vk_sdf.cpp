@@ -0,0 +1,112 @@
+#include "ekg/gpu/gpu_vk_sdf.hpp"
+#include "ekg/gpu/gpu_vk_renderer.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/env.hpp"
+#include "ekg/util/trace.hpp"
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+bool ekg::gpu::sdf_renderer::load_shaders(std::string_view vertex_shader_path, std::string_view fragment_shader_path) {
+    VkVertexInputBindingDescription binding {};
+    binding.binding = 0;
+    binding.stride = sizeof(ekg::gpu::sdf_primitive);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    this->pipeline.vertex_bindings = {binding};
+    this->pipeline.vertex_attributes = {
+        {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(ekg::gpu::sdf_primitive, rect))},
+        {1, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(ekg::gpu::sdf_primitive, radius))},
+        {2, 0, VK_FORMAT_R32_UINT, static_cast<uint32_t>(offsetof(ekg::gpu::sdf_primitive, kind))},
+        {3, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(ekg::gpu::sdf_primitive, fill_color))},
+        {4, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(ekg::gpu::sdf_primitive, border_color))}
+    };
+
+    this->pipeline.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    this->pipeline.cull_mode = VK_CULL_MODE_NONE;
+    this->pipeline.alpha_blend = true;
+
+    return ekg::load_pipeline_shaders(this->pipeline, vertex_shader_path, fragment_shader_path);
+}
+
+bool ekg::gpu::sdf_renderer::init(uint32_t primitive_capacity) {
+    EKG_TRACE_SCOPE("create sdf renderer");
+
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+    this->capacity = primitive_capacity;
+
+    if (!vulkan.create_buffer(this->instance_buffer, this->instance_memory, static_cast<VkDeviceSize>(std::max(this->capacity, 1u)) * sizeof(ekg::gpu::sdf_primitive),
+                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        return false;
+    }
+
+    if (vkMapMemory(vulkan.vk_device, this->instance_memory, 0, VK_WHOLE_SIZE, 0, &this->mapped_instances) != VK_SUCCESS) {
+        ekg::log("failed to map sdf instance buffer!");
+        return false;
+    }
+
+    VkPushConstantRange push_constant_range {};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    push_constant_range.size = sizeof(float) * 2;
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(vulkan.vk_device, &pipeline_layout_info, ekg::gpu::host.get_callbacks(), &this->vk_pipeline_layout) != VK_SUCCESS) {
+        ekg::log("failed to create sdf pipeline layout!");
+        return false;
+    }
+
+    this->pipeline.layout = this->vk_pipeline_layout;
+    return ekg::create_pipeline(this->pipeline);
+}
+
+void ekg::gpu::sdf_renderer::destroy() {
+    VkDevice device {ekg::gpu::vulkan.vk_device};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    vkDestroyPipeline(device, this->pipeline.pipeline_info, callbacks);
+    vkDestroyPipelineLayout(device, this->vk_pipeline_layout, callbacks);
+
+    if (this->mapped_instances != nullptr) {
+        vkUnmapMemory(device, this->instance_memory);
+    }
+
+    vkDestroyBuffer(device, this->instance_buffer, callbacks);
+    vkFreeMemory(device, this->instance_memory, callbacks);
+    *this = {};
+}
+
+void ekg::gpu::sdf_renderer::upload(const ekg::gpu::sdf_primitive *primitives, uint32_t count) {
+    EKG_TRACE_SCOPE("sdf upload");
+
+    if (count > this->capacity) {
+        ekg::log("sdf renderer: " + std::to_string(count) + " primitives over capacity, truncated to " + std::to_string(this->capacity));
+        count = this->capacity;
+    }
+
+    if (this->mapped_instances != nullptr) {
+        std::memcpy(this->mapped_instances, primitives, count * sizeof(ekg::gpu::sdf_primitive));
+    }
+
+    this->primitive_count = count;
+}
+
+void ekg::gpu::sdf_renderer::draw(VkCommandBuffer command_buffer, VkExtent2D viewport) {
+    EKG_TRACE_SCOPE("sdf draw");
+
+    if (this->primitive_count == 0) {
+        return;
+    }
+
+    float constants[2] {static_cast<float>(viewport.width), static_cast<float>(viewport.height)};
+    VkDeviceSize offset {};
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.pipeline_info);
+    vkCmdPushConstants(command_buffer, this->vk_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), constants);
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &this->instance_buffer, &offset);
+    vkCmdDraw(command_buffer, 4, this->primitive_count, 0, 0);
+}
@@ -0,0 +1,307 @@
+#include "ekg/gpu/gpu_vk_tessellator.hpp"
+#include "ekg/gpu/gpu_vk_renderer.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/env.hpp"
+#include "ekg/util/trace.hpp"
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+namespace {
+    struct tessellate_constants {
+        float viewport[2] {};
+        uint32_t widget_count {};
+        uint32_t padding {};
+    };
+}
+
+void ekg::gpu::widget_tessellator::set_vertex_input(ekg::gpu::pipeline &pipeline) {
+    VkVertexInputBindingDescription binding {};
+    binding.binding = 0;
+    binding.stride = sizeof(ekg::gpu::widget_vertex);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription position_attribute {};
+    position_attribute.location = 0;
+    position_attribute.binding = 0;
+    position_attribute.format = VK_FORMAT_R32G32_SFLOAT;
+    position_attribute.offset = offsetof(ekg::gpu::widget_vertex, position);
+
+    VkVertexInputAttributeDescription color_attribute {};
+    color_attribute.location = 1;
+    color_attribute.binding = 0;
+    color_attribute.format = VK_FORMAT_R8G8B8A8_UNORM;
+    color_attribute.offset = offsetof(ekg::gpu::widget_vertex, color);
+
+    pipeline.vertex_bindings = {binding};
+    pipeline.vertex_attributes = {position_attribute, color_attribute};
+}
+
+bool ekg::gpu::widget_tessellator::load_shader(std::string_view compute_shader_path) {
+    this->compute_shader_code.clear();
+
+    if (!ekg::read_file(compute_shader_path, this->compute_shader_code)) {
+        ekg::log("failed to read tessellation compute shader!");
+        return false;
+    }
+
+    return true;
+}
+
+bool ekg::gpu::widget_tessellator::init(uint32_t widget_capacity) {
+    EKG_TRACE_SCOPE("create widget tessellator");
+
+    this->capacity = widget_capacity;
+    return this->create_buffers() && this->create_descriptor_set() && this->create_compute_pipeline();
+}
+
+bool ekg::gpu::widget_tessellator::create_buffers() {
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+    VkDeviceSize capacity_size {static_cast<VkDeviceSize>(std::max(this->capacity, 1u))};
+
+    bool flag {
+        vulkan.create_buffer(this->descriptor_buffer, this->descriptor_memory, capacity_size * sizeof(ekg::gpu::widget_descriptor),
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) &&
+        vulkan.create_buffer(this->vertex_buffer, this->vertex_memory, capacity_size * 4 * sizeof(ekg::gpu::widget_vertex),
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) &&
+        vulkan.create_buffer(this->index_buffer, this->index_memory, capacity_size * 6 * sizeof(uint32_t),
+                             VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) &&
+        vulkan.create_buffer(this->indirect_buffer, this->indirect_memory, sizeof(VkDrawIndexedIndirectCommand),
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    };
+
+    if (flag && vkMapMemory(vulkan.vk_device, this->descriptor_memory, 0, VK_WHOLE_SIZE, 0, &this->mapped_descriptors) != VK_SUCCESS) {
+        ekg::log("failed to map widget descriptor buffer!");
+        flag = false;
+    }
+
+    /* Culled quads are compacted, so the quad index pattern never changes and is written once here. */
+    void *mapped_indices {};
+    if (flag && vkMapMemory(vulkan.vk_device, this->index_memory, 0, VK_WHOLE_SIZE, 0, &mapped_indices) != VK_SUCCESS) {
+        ekg::log("failed to map widget index buffer!");
+        flag = false;
+    }
+
+    if (mapped_indices != nullptr) {
+        uint32_t *indices {static_cast<uint32_t*>(mapped_indices)};
+        for (uint32_t quad {}; quad < capacity_size; quad++) {
+            uint32_t vertex {quad * 4};
+            uint32_t *index {indices + quad * 6};
+
+            index[0] = vertex + 0;
+            index[1] = vertex + 1;
+            index[2] = vertex + 2;
+            index[3] = vertex + 2;
+            index[4] = vertex + 3;
+            index[5] = vertex + 0;
+        }
+
+        vkUnmapMemory(vulkan.vk_device, this->index_memory);
+    }
+
+    return flag;
+}
+
+bool ekg::gpu::widget_tessellator::create_descriptor_set() {
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+
+    VkDescriptorSetLayoutBinding bindings[3] {};
+    for (uint32_t i = 0; i < 3; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 3;
+    layout_info.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(vulkan.vk_device, &layout_info, ekg::gpu::host.get_callbacks(), &this->vk_descriptor_set_layout) != VK_SUCCESS) {
+        ekg::log("failed to create tessellation descriptor set layout!");
+        return false;
+    }
+
+    VkDescriptorPoolSize pool_size {};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = 3;
+
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(vulkan.vk_device, &pool_info, ekg::gpu::host.get_callbacks(), &this->vk_descriptor_pool) != VK_SUCCESS) {
+        ekg::log("failed to create tessellation descriptor pool!");
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = this->vk_descriptor_pool;
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &this->vk_descriptor_set_layout;
+
+    if (vkAllocateDescriptorSets(vulkan.vk_device, &allocate_info, &this->vk_descriptor_set) != VK_SUCCESS) {
+        ekg::log("failed to allocate tessellation descriptor set!");
+        return false;
+    }
+
+    VkDescriptorBufferInfo buffer_infos[3] {};
+    buffer_infos[0].buffer = this->descriptor_buffer;
+    buffer_infos[1].buffer = this->vertex_buffer;
+    buffer_infos[2].buffer = this->indirect_buffer;
+
+    VkWriteDescriptorSet writes[3] {};
+    for (uint32_t i = 0; i < 3; i++) {
+        buffer_infos[i].range = VK_WHOLE_SIZE;
+
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = this->vk_descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffer_infos[i];
+    }
+
+    vkUpdateDescriptorSets(vulkan.vk_device, 3, writes, 0, nullptr);
+    return true;
+}
+
+bool ekg::gpu::widget_tessellator::create_compute_pipeline() {
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+
+    VkPushConstantRange push_constant_range {};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.size = sizeof(tessellate_constants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &this->vk_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(vulkan.vk_device, &pipeline_layout_info, ekg::gpu::host.get_callbacks(), &this->vk_pipeline_layout) != VK_SUCCESS) {
+        ekg::log("failed to create tessellation pipeline layout!");
+        return false;
+    }
+
+    VkShaderModule compute_shader_module {};
+    if (!vulkan.create_shader_module(compute_shader_module, this->compute_shader_code)) {
+        ekg::log("failed to create tessellation shader module!");
+        return false;
+    }
+
+    VkComputePipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = compute_shader_module;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = this->vk_pipeline_layout;
+
+    VkResult result {vkCreateComputePipelines(vulkan.vk_device, vulkan.vk_pipeline_cache, 1, &pipeline_info, ekg::gpu::host.get_callbacks(), &this->vk_pipeline)};
+    vkDestroyShaderModule(vulkan.vk_device, compute_shader_module, ekg::gpu::host.get_callbacks());
+    this->compute_shader_code = {};
+
+    if (result != VK_SUCCESS) {
+        ekg::log("failed to create tessellation compute pipeline!");
+        return false;
+    }
+
+    return true;
+}
+
+void ekg::gpu::widget_tessellator::destroy() {
+    VkDevice device {ekg::gpu::vulkan.vk_device};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    vkDestroyPipeline(device, this->vk_pipeline, callbacks);
+    vkDestroyPipelineLayout(device, this->vk_pipeline_layout, callbacks);
+    vkDestroyDescriptorPool(device, this->vk_descriptor_pool, callbacks);
+    vkDestroyDescriptorSetLayout(device, this->vk_descriptor_set_layout, callbacks);
+
+    if (this->mapped_descriptors != nullptr) {
+        vkUnmapMemory(device, this->descriptor_memory);
+        this->mapped_descriptors = nullptr;
+    }
+
+    for (auto [buffer, memory] : {
+            std::make_pair(this->descriptor_buffer, this->descriptor_memory),
+            std::make_pair(this->vertex_buffer, this->vertex_memory),
+            std::make_pair(this->index_buffer, this->index_memory),
+            std::make_pair(this->indirect_buffer, this->indirect_memory)}) {
+        vkDestroyBuffer(device, buffer, callbacks);
+        vkFreeMemory(device, memory, callbacks);
+    }
+
+    *this = {};
+}
+
+void ekg::gpu::widget_tessellator::upload(const ekg::gpu::widget_descriptor *descriptors, uint32_t count) {
+    EKG_TRACE_SCOPE("widget upload");
+
+    if (count > this->capacity) {
+        ekg::log("widget tessellator: " + std::to_string(count) + " widgets over capacity, truncated to " + std::to_string(this->capacity));
+        count = this->capacity;
+    }
+
+    if (this->mapped_descriptors != nullptr) {
+        std::memcpy(this->mapped_descriptors, descriptors, count * sizeof(ekg::gpu::widget_descriptor));
+    }
+
+    this->widget_count = count;
+}
+
+void ekg::gpu::widget_tessellator::dispatch(VkCommandBuffer command_buffer, VkExtent2D viewport) {
+    EKG_TRACE_SCOPE("widget dispatch");
+
+    /* Dispatched once per window in the same command buffer, the previous draw must be done reading. */
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    VkDrawIndexedIndirectCommand reset_command {0, 1, 0, 0, 0};
+    vkCmdUpdateBuffer(command_buffer, this->indirect_buffer, 0, sizeof(reset_command), &reset_command);
+
+    VkMemoryBarrier reset_barrier {};
+    reset_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &reset_barrier, 0, nullptr, 0, nullptr);
+
+    if (this->widget_count != 0) {
+        tessellate_constants constants {};
+        constants.viewport[0] = static_cast<float>(viewport.width);
+        constants.viewport[1] = static_cast<float>(viewport.height);
+        constants.widget_count = this->widget_count;
+
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->vk_pipeline);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->vk_pipeline_layout, 0, 1, &this->vk_descriptor_set, 0, nullptr);
+        vkCmdPushConstants(command_buffer, this->vk_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(command_buffer, (this->widget_count + 63) / 64, 1, 1);
+    }
+
+    VkMemoryBarrier draw_barrier {};
+    draw_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    draw_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    draw_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &draw_barrier, 0, nullptr, 0, nullptr);
+}
+
+void ekg::gpu::widget_tessellator::draw(VkCommandBuffer command_buffer, ekg::gpu::pipeline &pipeline) {
+    EKG_TRACE_SCOPE("widget draw");
+
+    VkDeviceSize offset {};
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline_info);
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &this->vertex_buffer, &offset);
+    vkCmdBindIndexBuffer(command_buffer, this->index_buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexedIndirect(command_buffer, this->indirect_buffer, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+}
@@ -0,0 +1,285 @@
+#include "ekg/gpu/gpu_vk_window.hpp"
+#include "ekg/gpu/gpu_vk_renderer.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/env.hpp"
+#include "ekg/util/trace.hpp"
+#include <SDL2/SDL_vulkan.h>
+#include <algorithm>
+#include <limits>
+
+bool ekg::gpu::vk_window::create_surface() {
+    EKG_TRACE_SCOPE("create surface");
+
+    if (!SDL_Vulkan_CreateSurface(this->sdl_window, ekg::gpu::vulkan.vk_instance, &this->vk_surface)) {
+        ekg::log("could not create vulkan surface!!");
+        return false;
+    }
+
+    return true;
+}
+
+bool ekg::gpu::vk_window::create_swap_chain(VkSwapchainKHR old_swap_chain) {
+    EKG_TRACE_SCOPE("create swap chain");
+
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+    ekg::gpu::queue_families indicies {};
+    vulkan.find_queue_families(indicies, vulkan.vk_physical_device);
+
+    /* The present queue was picked against the first window, every other one must be presentable from it too. */
+    VkBool32 present_support {};
+    vkGetPhysicalDeviceSurfaceSupportKHR(vulkan.vk_physical_device, indicies.present_family.value(), this->vk_surface, &present_support);
+
+    if (!present_support) {
+        ekg::log("window surface can not be presented from the shared present queue!");
+        return false;
+    }
+
+    ekg::gpu::swap_chain_support_details support {};
+    vulkan.query_swap_chain_support(support, vulkan.vk_physical_device, this->vk_surface);
+
+    VkSurfaceFormatKHR surface_format {this->choose_swap_surface_format(support.formats)};
+    VkPresentModeKHR present_mode_format {this->choose_swap_present_mode_format(support.present_modes)};
+    VkExtent2D extent {choose_swap_extent(support.capabilities)};
+
+    uint32_t image_count {support.capabilities.minImageCount + 1};
+    if (support.capabilities.maxImageCount > 0 && image_count > support.capabilities.maxImageCount) {
+        image_count = support.capabilities.maxImageCount;
+    }
+
+    VkSwapchainCreateInfoKHR create_info {};
+    create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    create_info.surface = this->vk_surface;
+    create_info.minImageCount = image_count;
+    create_info.imageFormat = surface_format.format;
+    create_info.imageColorSpace = surface_format.colorSpace;
+    create_info.imageExtent = extent;
+    create_info.imageArrayLayers = 1;
+    create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+    uint32_t queue_family_indices[] = {indicies.graphics_family.value(), indicies.present_family.value()};
+
+    if (indicies.graphics_family != indicies.present_family) {
+        create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+        create_info.queueFamilyIndexCount = 2;
+        create_info.pQueueFamilyIndices = queue_family_indices;
+    } else {
+        create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+
+    create_info.preTransform = support.capabilities.currentTransform;
+    create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    create_info.presentMode = present_mode_format;
+    create_info.clipped = VK_TRUE;
+    create_info.oldSwapchain = old_swap_chain;
+
+    if (vkCreateSwapchainKHR(vulkan.vk_device, &create_info, ekg::gpu::host.get_callbacks(), &this->vk_swap_chain) != VK_SUCCESS) {
+        ekg::log("failed to create swap chain!");
+        return false;
+    }
+
+    vkGetSwapchainImagesKHR(vulkan.vk_device, this->vk_swap_chain, &image_count, nullptr);
+    this->swap_chain_images.resize(image_count);
+    vkGetSwapchainImagesKHR(vulkan.vk_device, this->vk_swap_chain, &image_count, this->swap_chain_images.data());
+
+    this->vk_swap_chain_image_format = surface_format.format;
+    this->vk_swap_chain_extent = extent;
+    return true;
+}
+
+VkSurfaceFormatKHR ekg::gpu::vk_window::choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR> &available_formats) {
+    for (const auto &available_format : available_formats) {
+        if (available_format.format == VK_FORMAT_B8G8R8A8_SRGB && available_format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+            return available_format;
+        }
+    }
+
+    return available_formats[0];
+}
+
+VkPresentModeKHR ekg::gpu::vk_window::choose_swap_present_mode_format(const std::vector<VkPresentModeKHR> &available_present_modes) {
+    for (const auto &available_present_mode : available_present_modes) {
+        if (available_present_mode == VK_PRESENT_MODE_MAILBOX_KHR) {
+            return available_present_mode;
+        }
+    }
+
+    return available_present_modes[0];
+}
+
+VkExtent2D ekg::gpu::vk_window::choose_swap_extent(const VkSurfaceCapabilitiesKHR &capabilities) {
+    if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+        return capabilities.currentExtent;
+    } else {
+        int32_t framebuffer_w {}, framebuffer_h {};
+        SDL_Vulkan_GetDrawableSize(this->sdl_window, &framebuffer_w, &framebuffer_h);
+
+        VkExtent2D actual_extent {
+            static_cast<uint32_t>(framebuffer_w),
+            static_cast<uint32_t>(framebuffer_h)
+        };
+
+        actual_extent.width = std::clamp(actual_extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        actual_extent.height = std::clamp(actual_extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+
+        return actual_extent;
+    }
+}
+
+bool ekg::gpu::vk_window::create_image_views() {
+    EKG_TRACE_SCOPE("create image views");
+
+    this->swap_chain_image_view.resize(this->swap_chain_images.size());
+
+    for (size_t i = 0; i < this->swap_chain_images.size(); i++) {
+        VkImageViewCreateInfo create_info {};
+        create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        create_info.image = this->swap_chain_images[i];
+        create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        create_info.format = this->vk_swap_chain_image_format;
+        create_info.components.r = VK_COMPONENT_SWIZZLE_R;
+        create_info.components.g = VK_COMPONENT_SWIZZLE_G;
+        create_info.components.b = VK_COMPONENT_SWIZZLE_B;
+        create_info.components.a = VK_COMPONENT_SWIZZLE_A;
+        create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        create_info.subresourceRange.baseMipLevel = 0;
+        create_info.subresourceRange.levelCount = 1;
+        create_info.subresourceRange.baseArrayLayer = 0;
+        create_info.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(ekg::gpu::vulkan.vk_device, &create_info, ekg::gpu::host.get_callbacks(), &this->swap_chain_image_view[i]) != VK_SUCCESS) {
+            ekg::log("failed to create image views!");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ekg::gpu::vk_window::create_sync_objects() {
+    VkSemaphoreCreateInfo semaphore_info {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    if (vkCreateSemaphore(ekg::gpu::vulkan.vk_device, &semaphore_info, ekg::gpu::host.get_callbacks(), &this->vk_image_available_semaphore) != VK_SUCCESS) {
+        ekg::log("failed to create window sync objects!");
+        return false;
+    }
+
+    return true;
+}
+
+bool ekg::gpu::vk_window::create_render_graph() {
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+
+    /* Shared pipelines are built against `vk_render_pass`, a window of another format can not use them. */
+    if (this->vk_swap_chain_image_format != vulkan.windows.front()->vk_swap_chain_image_format) {
+        ekg::log("window swap chain format differs from the first window, shared pipelines are not compatible with it!");
+        return false;
+    }
+
+    this->graph.set_cache(&vulkan.render_pass_cache);
+    this->swap_chain_resource = this->graph.import_image("swap chain", this->vk_swap_chain_image_format, this->vk_swap_chain_extent,
+                                                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    return true;
+}
+
+bool ekg::gpu::vk_window::recreate_swap_chain() {
+    EKG_TRACE_SCOPE("recreate swap chain");
+
+    /* A minimized window has no drawable area, it stays out of date until it is restored. */
+    int32_t drawable_w {}, drawable_h {};
+    SDL_Vulkan_GetDrawableSize(this->sdl_window, &drawable_w, &drawable_h);
+
+    if (drawable_w == 0 || drawable_h == 0) {
+        return false;
+    }
+
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    vkDeviceWaitIdle(vulkan.vk_device);
+    vulkan.render_pass_cache.clear_framebuffers(this->swap_chain_image_view);
+
+    for (VkImageView &image_view : this->swap_chain_image_view) {
+        vkDestroyImageView(vulkan.vk_device, image_view, callbacks);
+    }
+
+    this->swap_chain_image_view.clear();
+
+    /* The old swap chain is retired by the new one, and destroyed either way. */
+    VkSwapchainKHR old_swap_chain {this->vk_swap_chain};
+    this->vk_swap_chain = VK_NULL_HANDLE;
+
+    bool created {this->create_swap_chain(old_swap_chain)};
+    vkDestroySwapchainKHR(vulkan.vk_device, old_swap_chain, callbacks);
+
+    if (!created || !this->create_image_views()) {
+        ekg::log("failed to recreate swap chain!");
+        return false;
+    }
+
+    /* Compiled here and not lazily while recording, where a failure would leave the acquired image undefined. */
+    this->graph.set_extent(this->swap_chain_resource, this->vk_swap_chain_extent);
+    if (!this->graph.compile()) {
+        ekg::log("failed to recompile render graph!");
+        return false;
+    }
+
+    this->out_of_date = false;
+    return true;
+}
+
+bool ekg::gpu::vk_window::acquire() {
+    this->acquired = false;
+
+    if ((this->out_of_date || this->vk_swap_chain == VK_NULL_HANDLE) && !this->recreate_swap_chain()) {
+        return false;
+    }
+
+    VkResult result {vkAcquireNextImageKHR(ekg::gpu::vulkan.vk_device, this->vk_swap_chain, std::numeric_limits<uint64_t>::max(), this->vk_image_available_semaphore, VK_NULL_HANDLE, &this->current_image_index)};
+
+    /* Nothing was signaled, so the semaphore can be reused right away for the new swap chain. */
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        if (!this->recreate_swap_chain()) {
+            return false;
+        }
+
+        result = vkAcquireNextImageKHR(ekg::gpu::vulkan.vk_device, this->vk_swap_chain, std::numeric_limits<uint64_t>::max(), this->vk_image_available_semaphore, VK_NULL_HANDLE, &this->current_image_index);
+    }
+
+    /* Still presentable, the semaphore is signaled; draw this frame and recreate on the next one. */
+    if (result == VK_SUBOPTIMAL_KHR) {
+        this->out_of_date = true;
+    }
+
+    this->acquired = result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR;
+
+    if (!this->acquired) {
+        this->out_of_date = result == VK_ERROR_OUT_OF_DATE_KHR;
+        ekg::log("failed to acquire swap chain image!");
+        return false;
+    }
+
+    this->graph.set_image(this->swap_chain_resource, this->swap_chain_images[this->current_image_index], this->swap_chain_image_view[this->current_image_index]);
+    return true;
+}
+
+void ekg::gpu::vk_window::destroy() {
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    if (vulkan.vk_device != VK_NULL_HANDLE) {
+        this->graph.destroy();
+        vkDestroySemaphore(vulkan.vk_device, this->vk_image_available_semaphore, callbacks);
+
+        for (VkImageView &image_view : this->swap_chain_image_view) {
+            vkDestroyImageView(vulkan.vk_device, image_view, callbacks);
+        }
+
+        vkDestroySwapchainKHR(vulkan.vk_device, this->vk_swap_chain, callbacks);
+    }
+
+    /* Created by SDL with the default allocator. */
+    if (this->vk_surface != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(vulkan.vk_instance, this->vk_surface, nullptr);
+    }
+}
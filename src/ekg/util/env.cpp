@@ -24,7 +24,7 @@ bool ekg::read_file(std::string_view path, std::string &file_string_data) {
 }
 
 bool ekg::read_file(std::string_view path, std::vector<char> &buffer) {
-    std::ifstream ifs {path.data()};
+    std::ifstream ifs {path.data(), std::ios::binary | std::ios::ate};
     if (ifs.is_open()) {
         size_t file_size {(size_t) ifs.tellg()};
         buffer.resize(file_size);
@@ -0,0 +1,217 @@
+#include "ekg/util/task_graph.hpp"
+#include "ekg/util/env.hpp"
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdio>
+
+static uint64_t steady_us() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void ekg::task_graph::add(std::string_view tag, const std::function<bool()> &function, const std::vector<std::string> &dependencies, bool main_thread) {
+    ekg::task &task {this->tasks.emplace_back()};
+    task.tag = tag;
+    task.function = function;
+    task.dependencies = dependencies;
+    task.main_thread = main_thread;
+}
+
+void ekg::task_graph::push_ready(size_t index) {
+    if (this->tasks[index].main_thread) {
+        this->main_thread_queue.push_back(index);
+    } else {
+        this->ready_queue.push_back(index);
+    }
+}
+
+bool ekg::task_graph::resolve() {
+    std::unordered_map<std::string, size_t> tag_map {};
+    for (size_t it {}; it < this->tasks.size(); it++) {
+        if (!tag_map.emplace(this->tasks[it].tag, it).second) {
+            ekg::log("task graph: duplicated task '" + this->tasks[it].tag + "'");
+            return false;
+        }
+    }
+
+    for (ekg::task &task : this->tasks) {
+        task.dependents.clear();
+        task.pending_dependencies = 0;
+        task.failed = false;
+        task.skipped = false;
+    }
+
+    for (size_t it {}; it < this->tasks.size(); it++) {
+        for (const std::string &dependency : this->tasks[it].dependencies) {
+            auto found {tag_map.find(dependency)};
+            if (found == tag_map.end()) {
+                ekg::log("task graph: task '" + this->tasks[it].tag + "' depends on unknown task '" + dependency + "'");
+                return false;
+            }
+
+            this->tasks[found->second].dependents.push_back(it);
+            this->tasks[it].pending_dependencies++;
+        }
+    }
+
+    /* Kahn's walk over a copy of the counters, only to reject cycles before any thread starts. */
+    std::vector<size_t> pending {};
+    std::vector<size_t> stack {};
+    size_t visited {};
+
+    for (size_t it {}; it < this->tasks.size(); it++) {
+        pending.push_back(this->tasks[it].pending_dependencies);
+        if (pending.back() == 0) stack.push_back(it);
+    }
+
+    while (!stack.empty()) {
+        size_t index {stack.back()};
+        stack.pop_back();
+        visited++;
+
+        for (size_t dependent : this->tasks[index].dependents) {
+            if (--pending[dependent] == 0) stack.push_back(dependent);
+        }
+    }
+
+    if (visited != this->tasks.size()) {
+        ekg::log("task graph: dependency cycle detected");
+        return false;
+    }
+
+    return true;
+}
+
+void ekg::task_graph::work(uint32_t thread_index, uint64_t begin_us) {
+    std::unique_lock<std::mutex> lock {this->mutex};
+
+    /* Only the calling thread (worker 0) takes main thread tasks, and before any other ready one. */
+    bool main_thread {thread_index == 0};
+
+    while (true) {
+        this->condition.wait(lock, [this, main_thread]() {
+            return !this->ready_queue.empty() || (main_thread && !this->main_thread_queue.empty()) || this->completed_tasks == this->tasks.size();
+        });
+
+        std::deque<size_t> &queue {main_thread && !this->main_thread_queue.empty() ? this->main_thread_queue : this->ready_queue};
+        if (queue.empty()) {
+            break;
+        }
+
+        size_t index {queue.front()};
+        queue.pop_front();
+
+        ekg::task &task {this->tasks[index]};
+        lock.unlock();
+
+        task.thread_index = thread_index;
+        task.begin_us = steady_us() - begin_us;
+
+        /* `skipped` is only written under the lock by dependencies, all done before this task was queued. */
+        if (!task.skipped) {
+            task.failed = !task.function();
+        }
+
+        task.end_us = steady_us() - begin_us;
+
+        lock.lock();
+        this->completed_tasks++;
+
+        if (task.failed) {
+            this->failed_tasks++;
+            ekg::log("task graph: task '" + task.tag + "' failed");
+        } else if (task.skipped) {
+            ekg::log("task graph: task '" + task.tag + "' skipped, a dependency failed");
+        }
+
+        for (size_t dependent : task.dependents) {
+            this->tasks[dependent].skipped = this->tasks[dependent].skipped || task.failed || task.skipped;
+
+            if (--this->tasks[dependent].pending_dependencies == 0) {
+                this->push_ready(dependent);
+            }
+        }
+
+        this->condition.notify_all();
+    }
+}
+
+bool ekg::task_graph::run(uint32_t thread_count) {
+    if (!this->resolve()) {
+        return false;
+    }
+
+    if (thread_count == 0) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    thread_count = std::min(thread_count, static_cast<uint32_t>(std::max(this->tasks.size(), static_cast<size_t>(1))));
+
+    this->ready_queue.clear();
+    this->main_thread_queue.clear();
+    this->completed_tasks = 0;
+    this->failed_tasks = 0;
+
+    for (size_t it {}; it < this->tasks.size(); it++) {
+        if (this->tasks[it].pending_dependencies == 0) this->push_ready(it);
+    }
+
+    uint64_t begin_us {steady_us()};
+    std::vector<std::thread> workers {};
+
+    /* The calling thread is the worker 0, so a single-threaded run spawns nothing. */
+    for (uint32_t it {1}; it < thread_count; it++) {
+        workers.emplace_back(&ekg::task_graph::work, this, it, begin_us);
+    }
+
+    this->work(0, begin_us);
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    this->elapsed_us = steady_us() - begin_us;
+    return this->failed_tasks == 0;
+}
+
+void ekg::task_graph::report(std::string_view graph_tag) {
+    std::vector<const ekg::task*> sorted_tasks {};
+    uint64_t serial_us {};
+
+    for (const ekg::task &task : this->tasks) {
+        sorted_tasks.push_back(&task);
+        serial_us += task.end_us - task.begin_us;
+    }
+
+    std::sort(sorted_tasks.begin(), sorted_tasks.end(), [](const ekg::task *a, const ekg::task *b) {
+        return a->begin_us < b->begin_us;
+    });
+
+    char buffer[256] {};
+    for (const ekg::task *task : sorted_tasks) {
+        std::snprintf(buffer, sizeof(buffer), "%.*s: %-24s %9.3fms (at +%.3fms, thread %u)%s", static_cast<int>(graph_tag.size()), graph_tag.data(), task->tag.c_str(), static_cast<double>(task->end_us - task->begin_us) / 1000.0, static_cast<double>(task->begin_us) / 1000.0, task->thread_index,
+                      task->failed ? " failed" : (task->skipped ? " skipped" : ""));
+        ekg::log(buffer);
+    }
+
+    std::snprintf(buffer, sizeof(buffer), "%.*s: total %.3fms (serial sum %.3fms)", static_cast<int>(graph_tag.size()), graph_tag.data(), static_cast<double>(this->elapsed_us) / 1000.0, static_cast<double>(serial_us) / 1000.0);
+    ekg::log(buffer);
+}
+
+void ekg::task_graph::clear() {
+    this->tasks.clear();
+    this->ready_queue.clear();
+    this->main_thread_queue.clear();
+    this->completed_tasks = 0;
+    this->failed_tasks = 0;
+    this->elapsed_us = 0;
+}
+
+const std::vector<ekg::task> &ekg::task_graph::get_tasks() {
+    return this->tasks;
+}
+
+uint64_t ekg::task_graph::get_elapsed_us() {
+    return this->elapsed_us;
+}
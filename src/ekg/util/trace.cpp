@@ -0,0 +1,243 @@
+#include "ekg/util/trace.hpp"
+
+#ifdef EKG_TRACE
+#include "ekg/util/env.hpp"
+#include <atomic>
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <csignal>
+#include <algorithm>
+
+namespace {
+    /*
+     * Every field is atomic and `sequence` is the ring index + 1 once the slot is complete
+     * (0 while it is written), so the dump copies a slot and keeps it only if the sequence
+     * read before and after the copy is the one it expects: a slot being overwritten is dropped.
+     */
+    struct zone {
+        std::atomic<uint64_t> sequence {};
+        std::atomic<const char*> name {};
+        std::atomic<uint64_t> begin_ns {};
+        std::atomic<uint64_t> end_ns {};
+    };
+
+    /* One ring per live thread, written only by its owner and handed to a new thread when the owner exits. */
+    struct thread_buffer {
+        static constexpr uint64_t capacity {1 << 16};
+
+        uint32_t thread_index {};
+        std::array<zone, capacity> zones {};
+        std::atomic<uint64_t> write_index {};
+    };
+
+    /* Image index per window, `frame_no_image` when the window did not acquire. */
+    constexpr uint32_t frame_max_windows {8};
+    constexpr uint8_t frame_no_image {0xFF};
+
+    struct frame {
+        std::atomic<uint64_t> sequence {};
+        std::atomic<uint64_t> frame {};
+        std::atomic<uint64_t> begin_ns {};
+        std::array<std::atomic<uint8_t>, frame_max_windows> image_indices {};
+        std::atomic<uint32_t> window_count {};
+    };
+
+    constexpr uint64_t frame_capacity {512};
+
+    std::mutex registry_mutex {};
+    std::vector<std::unique_ptr<thread_buffer>> registry {};
+    std::vector<thread_buffer*> free_buffers {};
+
+    std::array<frame, frame_capacity> frames {};
+    std::atomic<uint64_t> frame_write_index {};
+    std::atomic<bool> dump_requested {};
+
+    struct thread_owner {
+        thread_buffer *buffer {};
+
+        ~thread_owner() {
+            if (this->buffer != nullptr) {
+                std::lock_guard<std::mutex> lock {registry_mutex};
+                free_buffers.push_back(this->buffer);
+            }
+        }
+    };
+
+    thread_buffer *get_thread_buffer() {
+        thread_local thread_owner owner {};
+
+        if (owner.buffer == nullptr) {
+            std::lock_guard<std::mutex> lock {registry_mutex};
+
+            /* Short-lived workers (the startup graph spawns a pool per run) reuse the rings of exited threads. */
+            if (!free_buffers.empty()) {
+                owner.buffer = free_buffers.back();
+                free_buffers.pop_back();
+            } else {
+                registry.push_back(std::make_unique<thread_buffer>());
+                owner.buffer = registry.back().get();
+                owner.buffer->thread_index = static_cast<uint32_t>(registry.size() - 1);
+            }
+        }
+
+        return owner.buffer;
+    }
+
+    void write_escaped(std::ofstream &ofs, const char *string) {
+        for (; *string != '\0'; string++) {
+            if (*string == '"' || *string == '\\') ofs << '\\';
+            ofs << *string;
+        }
+    }
+
+    void on_signal(int) {
+        dump_requested.store(true, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ekg::trace::now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void ekg::trace::record(const char *name, uint64_t begin_ns, uint64_t end_ns) {
+    thread_buffer *buffer {get_thread_buffer()};
+    uint64_t index {buffer->write_index.load(std::memory_order_relaxed)};
+    zone &slot {buffer->zones[index % thread_buffer::capacity]};
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    slot.end_ns.store(end_ns, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+
+    buffer->write_index.store(index + 1, std::memory_order_release);
+}
+
+void ekg::trace::frame_mark(uint64_t frame_number, const uint32_t *image_indices, uint32_t window_count) {
+    uint64_t index {frame_write_index.load(std::memory_order_relaxed)};
+    frame &mark {frames[index % frame_capacity]};
+    window_count = std::min(window_count, frame_max_windows);
+
+    mark.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mark.frame.store(frame_number, std::memory_order_relaxed);
+    mark.begin_ns.store(ekg::trace::now_ns(), std::memory_order_relaxed);
+    mark.window_count.store(window_count, std::memory_order_relaxed);
+
+    for (uint32_t it {}; it < window_count; it++) {
+        mark.image_indices[it].store(image_indices[it] < frame_no_image ? static_cast<uint8_t>(image_indices[it]) : frame_no_image, std::memory_order_relaxed);
+    }
+
+    mark.sequence.store(index + 1, std::memory_order_release);
+    frame_write_index.store(index + 1, std::memory_order_release);
+}
+
+void ekg::trace::install_signal() {
+#ifdef SIGUSR1
+    std::signal(SIGUSR1, on_signal);
+#endif
+}
+
+void ekg::trace::request_dump() {
+    dump_requested.store(true, std::memory_order_relaxed);
+}
+
+bool ekg::trace::poll_dump(std::string_view path, uint32_t frame_count) {
+    if (!dump_requested.exchange(false, std::memory_order_relaxed)) {
+        return false;
+    }
+
+    return ekg::trace::dump(path, frame_count);
+}
+
+bool ekg::trace::dump(std::string_view path, uint32_t frame_count) {
+    std::ofstream ofs {path.data()};
+    if (!ofs.is_open()) {
+        ekg::log("trace: could not open '" + std::string(path) + "'");
+        return false;
+    }
+
+    /* Everything since the oldest of the last `frame_count` frame marks is written. */
+    uint64_t frame_end {frame_write_index.load(std::memory_order_acquire)};
+    uint64_t frame_begin {frame_end - std::min<uint64_t>({frame_end, frame_count, frame_capacity})};
+    uint64_t cutoff_ns {};
+    uint64_t frame_written {};
+
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    ofs << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ekg\"}}";
+
+    for (uint64_t it {frame_begin}; it < frame_end; it++) {
+        const frame &mark {frames[it % frame_capacity]};
+        if (mark.sequence.load(std::memory_order_acquire) != it + 1) {
+            continue;
+        }
+
+        uint64_t frame_number {mark.frame.load(std::memory_order_relaxed)};
+        uint64_t begin_ns {mark.begin_ns.load(std::memory_order_relaxed)};
+        uint32_t window_count {mark.window_count.load(std::memory_order_relaxed)};
+        std::array<uint8_t, frame_max_windows> image_indices {};
+
+        for (uint32_t window {}; window < window_count; window++) {
+            image_indices[window] = mark.image_indices[window].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (mark.sequence.load(std::memory_order_relaxed) != it + 1) {
+            continue;
+        }
+
+        cutoff_ns = frame_written++ == 0 ? begin_ns : cutoff_ns;
+        ofs << ",\n{\"name\":\"frame " << frame_number << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" << static_cast<double>(begin_ns) / 1000.0
+            << ",\"args\":{\"frame\":" << frame_number << ",\"image_indices\":[";
+
+        for (uint32_t window {}; window < window_count; window++) {
+            ofs << (window == 0 ? "" : ",");
+            if (image_indices[window] == frame_no_image) ofs << "null"; else ofs << static_cast<uint32_t>(image_indices[window]);
+        }
+
+        ofs << "]}}";
+    }
+
+    std::lock_guard<std::mutex> lock {registry_mutex};
+    uint64_t zone_count {};
+
+    for (const std::unique_ptr<thread_buffer> &buffer : registry) {
+        ofs << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_index << ",\"args\":{\"name\":\"thread " << buffer->thread_index << "\"}}";
+
+        uint64_t end {buffer->write_index.load(std::memory_order_acquire)};
+        uint64_t begin {end - std::min(end, thread_buffer::capacity)};
+
+        for (uint64_t it {begin}; it < end; it++) {
+            const zone &slot {buffer->zones[it % thread_buffer::capacity]};
+            if (slot.sequence.load(std::memory_order_acquire) != it + 1) {
+                continue;
+            }
+
+            const char *name {slot.name.load(std::memory_order_relaxed)};
+            uint64_t begin_ns {slot.begin_ns.load(std::memory_order_relaxed)};
+            uint64_t end_ns {slot.end_ns.load(std::memory_order_relaxed)};
+
+            /* Overwritten by the owner while copying. */
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != it + 1 || begin_ns < cutoff_ns || name == nullptr) {
+                continue;
+            }
+
+            ofs << ",\n{\"name\":\"";
+            write_escaped(ofs, name);
+            ofs << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_index << ",\"ts\":" << static_cast<double>(begin_ns) / 1000.0
+                << ",\"dur\":" << static_cast<double>(end_ns - begin_ns) / 1000.0 << "}";
+            zone_count++;
+        }
+    }
+
+    ofs << "\n]}\n";
+    ekg::log("trace: " + std::to_string(zone_count) + " zones of " + std::to_string(frame_written) + " frames written to '" + std::string(path) + "'");
+    return true;
+}
+#endif
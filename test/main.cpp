@@ -1,8 +1,22 @@
 #include "runtime.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include <cstdlib>
 
 static runtime core {};
 
-int32_t main(int, char**) {
+int32_t main(int32_t argc, char** argv) {
+    for (int32_t it {1}; it < argc; it++) {
+        std::string_view arg {argv[it]};
+
+        if (arg == "--bench") {
+            core.set_benchmark(true);
+        } else if (arg == "--strict-host") {
+            ekg::gpu::host.strict_steady_state = true;
+        } else if (arg == "--windows" && it + 1 < argc) {
+            core.set_window_count(static_cast<uint32_t>(std::atoi(argv[++it])));
+        }
+    }
+
     core.init();
     core.mainloop();
     core.quit();
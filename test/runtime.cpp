@@ -1,5 +1,12 @@
 #include "runtime.hpp"
 #include "util.hpp"
+#include "ekg/gpu/gpu_vk_host_allocator.hpp"
+#include "ekg/util/trace.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
 
 SDL_DisplayMode &runtime::get_display_mode() {
     return this->sdl_display_mode;
@@ -9,15 +16,398 @@ SDL_Window *runtime::get_sdl_window() {
     return this->sdl_window;
 }
 
+void runtime::set_benchmark(bool benchmark_mode) {
+    this->benchmark = benchmark_mode;
+}
+
+void runtime::set_window_count(uint32_t count) {
+    this->window_count = std::max(count, 1u);
+}
+
+void runtime::generate_widgets(uint32_t count) {
+    this->widgets.resize(count);
+
+    float w {static_cast<float>(this->sdl_display_mode.w)};
+    float h {static_cast<float>(this->sdl_display_mode.h)};
+    uint32_t columns {std::max(static_cast<uint32_t>(std::sqrt(static_cast<float>(count) * w / h)), 1u)};
+    float cell {w / static_cast<float>(columns)};
+
+    for (uint32_t it {}; it < count; it++) {
+        ekg::gpu::widget_descriptor &widget {this->widgets[it]};
+        widget.rect[0] = static_cast<float>(it % columns) * cell + 1.0f;
+        widget.rect[1] = static_cast<float>(it / columns) * cell + 1.0f;
+        widget.rect[2] = cell - 2.0f;
+        widget.rect[3] = cell - 2.0f;
+        widget.scissor[2] = w;
+        widget.scissor[3] = h;
+        widget.color = 0xFF000000 | (it * 2654435761u >> 8);
+        widget.flags = ekg::gpu::widget_flag_visible;
+    }
+}
+
+void runtime::generate_primitives(uint32_t count) {
+    this->primitives.clear();
+
+    if (!this->benchmark) {
+        ekg::gpu::sdf_primitive shadow {{64.0f, 72.0f, 320.0f, 200.0f}, 12.0f, 0.0f, 16.0f, ekg::gpu::sdf_kind_shadow, 0x80000000};
+        ekg::gpu::sdf_primitive card {{64.0f, 64.0f, 320.0f, 200.0f}, 12.0f, 2.0f, 0.0f, ekg::gpu::sdf_kind_rounded_rect, 0xFF2A2A2A, 0xFFE0A040};
+        ekg::gpu::sdf_primitive circle {{96.0f, 96.0f, 48.0f, 48.0f}, 0.0f, 0.0f, 0.0f, ekg::gpu::sdf_kind_circle, 0xFF40C0F0};
+        ekg::gpu::sdf_primitive border {{160.0f, 96.0f, 192.0f, 48.0f}, 6.0f, 1.5f, 0.0f, ekg::gpu::sdf_kind_border, 0, 0xFFFFFFFF};
+        this->primitives = {shadow, card, circle, border};
+        return;
+    }
+
+    /* Benchmark: one rounded rect with border over every widget cell. */
+    this->primitives.resize(count);
+
+    for (uint32_t it {}; it < count && it < this->widgets.size(); it++) {
+        ekg::gpu::sdf_primitive &primitive {this->primitives[it]};
+        std::copy(std::begin(this->widgets[it].rect), std::end(this->widgets[it].rect), primitive.rect);
+        primitive.radius = primitive.rect[2] * 0.25f;
+        primitive.border_width = 1.0f;
+        primitive.kind = ekg::gpu::sdf_kind_rounded_rect;
+        primitive.fill_color = this->widgets[it].color;
+        primitive.border_color = 0xFFFFFFFF;
+    }
+}
+
+/* The tessellated equivalent of a `sdf_kind_rounded_rect`: a fan with `segments` + 1 vertices per corner. */
+static void tessellate_rounded_rects_on_cpu(const std::vector<ekg::gpu::sdf_primitive> &primitives, std::vector<ekg::gpu::widget_vertex> &vertices, std::vector<uint32_t> &indices, uint32_t segments, float w, float h) {
+    vertices.clear();
+    indices.clear();
+
+    const float corner_angles[4] {3.14159265f, 4.71238898f, 0.0f, 1.57079633f};
+
+    for (const ekg::gpu::sdf_primitive &primitive : primitives) {
+        float radius {std::min(primitive.radius, std::min(primitive.rect[2], primitive.rect[3]) * 0.5f)};
+        float corners[4][2] {
+            {primitive.rect[0] + radius, primitive.rect[1] + radius},
+            {primitive.rect[0] + primitive.rect[2] - radius, primitive.rect[1] + radius},
+            {primitive.rect[0] + primitive.rect[2] - radius, primitive.rect[1] + primitive.rect[3] - radius},
+            {primitive.rect[0] + radius, primitive.rect[1] + primitive.rect[3] - radius}
+        };
+
+        uint32_t center {static_cast<uint32_t>(vertices.size())};
+        vertices.push_back({{(primitive.rect[0] + primitive.rect[2] * 0.5f) / w * 2.0f - 1.0f, (primitive.rect[1] + primitive.rect[3] * 0.5f) / h * 2.0f - 1.0f}, primitive.fill_color});
+
+        for (uint32_t corner {}; corner < 4; corner++) {
+            for (uint32_t segment {}; segment <= segments; segment++) {
+                float angle {corner_angles[corner] + 1.57079633f * static_cast<float>(segment) / static_cast<float>(segments)};
+                float x {corners[corner][0] + std::cos(angle) * radius};
+                float y {corners[corner][1] + std::sin(angle) * radius};
+                vertices.push_back({{x / w * 2.0f - 1.0f, y / h * 2.0f - 1.0f}, primitive.fill_color});
+            }
+        }
+
+        uint32_t ring {4 * (segments + 1)};
+        for (uint32_t it {}; it < ring; it++) {
+            indices.insert(indices.end(), {center, center + 1 + it, center + 1 + (it + 1) % ring});
+        }
+    }
+}
+
+/* Same expansion the compute shader does, only measured to compare against the GPU-driven path. */
+static void tessellate_on_cpu(const std::vector<ekg::gpu::widget_descriptor> &widgets, std::vector<ekg::gpu::widget_vertex> &vertices, std::vector<uint32_t> &indices, float w, float h) {
+    vertices.clear();
+    indices.clear();
+
+    for (const ekg::gpu::widget_descriptor &widget : widgets) {
+        float x0 {std::max(widget.rect[0], std::max(widget.scissor[0], 0.0f))};
+        float y0 {std::max(widget.rect[1], std::max(widget.scissor[1], 0.0f))};
+        float x1 {std::min(widget.rect[0] + widget.rect[2], std::min(widget.scissor[0] + widget.scissor[2], w))};
+        float y1 {std::min(widget.rect[1] + widget.rect[3], std::min(widget.scissor[1] + widget.scissor[3], h))};
+
+        if (!(widget.flags & ekg::gpu::widget_flag_visible) || x1 <= x0 || y1 <= y0) {
+            continue;
+        }
+
+        uint32_t vertex {static_cast<uint32_t>(vertices.size())};
+        x0 = x0 / w * 2.0f - 1.0f; x1 = x1 / w * 2.0f - 1.0f;
+        y0 = y0 / h * 2.0f - 1.0f; y1 = y1 / h * 2.0f - 1.0f;
+
+        vertices.push_back({{x0, y0}, widget.color});
+        vertices.push_back({{x1, y0}, widget.color});
+        vertices.push_back({{x1, y1}, widget.color});
+        vertices.push_back({{x0, y1}, widget.color});
+        indices.insert(indices.end(), {vertex, vertex + 1, vertex + 2, vertex + 2, vertex + 3, vertex});
+    }
+}
+
+/* Where `--bench` writes its timestamps, the GPU time of a path is the span between two of them. */
+static constexpr uint32_t timestamp_dispatch_begin {0};
+static constexpr uint32_t timestamp_dispatch_end {1};
+static constexpr uint32_t timestamp_ui_begin {2};
+static constexpr uint32_t timestamp_widgets_end {3};
+static constexpr uint32_t timestamp_sdf_end {4};
+static constexpr uint32_t timestamp_cpu_widgets_end {5};
+static constexpr uint32_t timestamp_rounded_rects_end {6};
+static constexpr uint32_t timestamp_count {7};
+
+bool cpu_geometry::init(uint32_t max_vertices, uint32_t max_indices) {
+    ekg::gpu::vk_renderer &vulkan {ekg::gpu::vulkan};
+    this->vertex_capacity = std::max(max_vertices, 1u);
+    this->index_capacity = std::max(max_indices, 1u);
+
+    if (!vulkan.create_buffer(this->vertex_buffer, this->vertex_memory, static_cast<VkDeviceSize>(this->vertex_capacity) * sizeof(ekg::gpu::widget_vertex),
+                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) ||
+        !vulkan.create_buffer(this->index_buffer, this->index_memory, static_cast<VkDeviceSize>(this->index_capacity) * sizeof(uint32_t),
+                              VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        return false;
+    }
+
+    if (vkMapMemory(vulkan.vk_device, this->vertex_memory, 0, VK_WHOLE_SIZE, 0, &this->mapped_vertices) != VK_SUCCESS ||
+        vkMapMemory(vulkan.vk_device, this->index_memory, 0, VK_WHOLE_SIZE, 0, &this->mapped_indices) != VK_SUCCESS) {
+        util::log("could not map cpu geometry buffers");
+        return false;
+    }
+
+    return true;
+}
+
+void cpu_geometry::upload(const std::vector<ekg::gpu::widget_vertex> &vertices, const std::vector<uint32_t> &indices) {
+    /* Indices past a truncated vertex range would read out of bounds, so over capacity draws nothing. */
+    if (vertices.size() > this->vertex_capacity || indices.size() > this->index_capacity || this->mapped_vertices == nullptr) {
+        this->index_count = 0;
+        return;
+    }
+
+    std::memcpy(this->mapped_vertices, vertices.data(), vertices.size() * sizeof(ekg::gpu::widget_vertex));
+    std::memcpy(this->mapped_indices, indices.data(), indices.size() * sizeof(uint32_t));
+    this->index_count = static_cast<uint32_t>(indices.size());
+}
+
+void cpu_geometry::draw(VkCommandBuffer command_buffer, ekg::gpu::pipeline &pipeline) {
+    if (this->index_count == 0) {
+        return;
+    }
+
+    VkDeviceSize offset {};
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline_info);
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &this->vertex_buffer, &offset);
+    vkCmdBindIndexBuffer(command_buffer, this->index_buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(command_buffer, this->index_count, 1, 0, 0, 0);
+}
+
+void cpu_geometry::destroy() {
+    VkDevice device {ekg::gpu::vulkan.vk_device};
+    const VkAllocationCallbacks *callbacks {ekg::gpu::host.get_callbacks()};
+
+    vkDestroyBuffer(device, this->vertex_buffer, callbacks);
+    vkFreeMemory(device, this->vertex_memory, callbacks);
+    vkDestroyBuffer(device, this->index_buffer, callbacks);
+    vkFreeMemory(device, this->index_memory, callbacks);
+
+    this->mapped_vertices = nullptr;
+    this->mapped_indices = nullptr;
+}
+
+bool runtime::create_render_graph(ekg::gpu::vk_window &created_window) {
+    /* Every window draws the same widgets from the shared buffers, only its viewport differs. */
+    ekg::gpu::vk_window *window {&created_window};
+    const VkClearColorValue black {{0.0f, 0.0f, 0.0f, 1.0f}};
+
+    /* Swap chain sized transients; the backdrop and the vertical blur never live together, so they alias one memory block. */
+    uint32_t backdrop {window->graph.create_image("backdrop", window->vk_swap_chain_image_format)};
+    uint32_t horizontal_blur {window->graph.create_image("horizontal blur", window->vk_swap_chain_image_format)};
+    uint32_t vertical_blur {window->graph.create_image("vertical blur", window->vk_swap_chain_image_format)};
+
+    uint32_t blur_sources[3] {};
+    if (!(this->blur.add_source(blur_sources[0]) && this->blur.add_source(blur_sources[1]) && this->blur.add_source(blur_sources[2]))) {
+        util::log("could not add blur sources");
+        return false;
+    }
+
+    window->graph.add_pass("widget tessellation", {}, [this, window](VkCommandBuffer command_buffer) {
+        auto dispatch_begin {std::chrono::steady_clock::now()};
+
+        /* Resets stay outside of render passes, the ui pass writes the rest. */
+        if (this->timestamp_pool != VK_NULL_HANDLE && window == this->renderer.windows.front().get()) {
+            vkCmdResetQueryPool(command_buffer, this->timestamp_pool, 0, timestamp_count);
+            vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->timestamp_pool, timestamp_dispatch_begin);
+            this->tessellator.dispatch(command_buffer, window->vk_swap_chain_extent);
+            vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->timestamp_pool, timestamp_dispatch_end);
+        } else {
+            this->tessellator.dispatch(command_buffer, window->vk_swap_chain_extent);
+        }
+
+        this->timings.gpu_driven += std::chrono::steady_clock::now() - dispatch_begin;
+    });
+
+    /* The widgets drawn offscreen, blurred in two separable passes and composited under the ui. */
+    window->graph.add_pass("backdrop", {{backdrop, ekg::gpu::access_color_attachment_write}}, [this](VkCommandBuffer command_buffer) {
+        this->tessellator.draw(command_buffer, this->pipeline);
+    }, true, black);
+
+    window->graph.add_pass("horizontal blur", {{backdrop, ekg::gpu::access_sampled}, {horizontal_blur, ekg::gpu::access_color_attachment_write}}, [this, source = blur_sources[0]](VkCommandBuffer command_buffer) {
+        this->blur.draw(command_buffer, source, 1.0f, 0.0f);
+    });
+
+    window->graph.add_pass("vertical blur", {{horizontal_blur, ekg::gpu::access_sampled}, {vertical_blur, ekg::gpu::access_color_attachment_write}}, [this, source = blur_sources[1]](VkCommandBuffer command_buffer) {
+        this->blur.draw(command_buffer, source, 0.0f, 1.0f);
+    });
+
+    window->graph.add_pass("ui", {{window->swap_chain_resource, ekg::gpu::access_color_attachment_write}, {vertical_blur, ekg::gpu::access_sampled}}, [this, window, source = blur_sources[2]](VkCommandBuffer command_buffer) {
+        this->blur.draw(command_buffer, source, 0.0f, 0.0f);
+
+        bool timed {this->timestamp_pool != VK_NULL_HANDLE && window == this->renderer.windows.front().get()};
+        auto timestamp {[this, timed, command_buffer](uint32_t query) {
+            if (timed) vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->timestamp_pool, query);
+        }};
+
+        auto draw_begin {std::chrono::steady_clock::now()};
+        timestamp(timestamp_ui_begin);
+        this->tessellator.draw(command_buffer, this->pipeline);
+        timestamp(timestamp_widgets_end);
+        auto sdf_begin {std::chrono::steady_clock::now()};
+        this->timings.gpu_driven += sdf_begin - draw_begin;
+
+        {
+            EKG_TRACE_SCOPE("sdf recording");
+            this->sdf.draw(command_buffer, window->vk_swap_chain_extent);
+            timestamp(timestamp_sdf_end);
+        }
+
+        auto sdf_end {std::chrono::steady_clock::now()};
+        this->timings.sdf += sdf_end - sdf_begin;
+
+        /* The same widgets and rounded rects again, tessellated on the CPU and drawn through the widget pipeline. */
+        if (this->benchmark) {
+            this->cpu_widgets.draw(command_buffer, this->pipeline);
+            timestamp(timestamp_cpu_widgets_end);
+            auto cpu_widgets_end {std::chrono::steady_clock::now()};
+
+            this->cpu_rounded_rects.draw(command_buffer, this->pipeline);
+            timestamp(timestamp_rounded_rects_end);
+
+            this->timings.cpu_tessellation += cpu_widgets_end - sdf_end;
+            this->timings.rounded_tessellation += std::chrono::steady_clock::now() - cpu_widgets_end;
+            this->timestamps_written = this->timestamps_written || timed;
+        }
+    }, true, black);
+
+    /* Recompiles on resize recreate the transients, the blur sources follow them. */
+    window->graph.on_compiled = [this, backdrop, horizontal_blur, vertical_blur, blur_sources](ekg::gpu::render_graph &graph) {
+        this->blur.set_source(blur_sources[0], graph.get_view(backdrop));
+        this->blur.set_source(blur_sources[1], graph.get_view(horizontal_blur));
+        this->blur.set_source(blur_sources[2], graph.get_view(vertical_blur));
+    };
+
+    if (!window->graph.compile()) {
+        util::log("could not compile render graph");
+        return false;
+    }
+
+    return true;
+}
+
+bool runtime::create_timestamp_pool() {
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(this->renderer.vk_physical_device, &properties);
+
+    /* The graphics queue can not write timestamps everywhere, the bench then logs CPU times only. */
+    if (!properties.limits.timestampComputeAndGraphics) {
+        util::log("no timestamp queries on the graphics queue, gpu times are not logged");
+        return true;
+    }
+
+    VkQueryPoolCreateInfo create_info {};
+    create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    create_info.queryCount = timestamp_count;
+
+    if (vkCreateQueryPool(this->renderer.vk_device, &create_info, ekg::gpu::host.get_callbacks(), &this->timestamp_pool) != VK_SUCCESS) {
+        util::log("could not create timestamp query pool");
+        return false;
+    }
+
+    this->timestamp_period = properties.limits.timestampPeriod;
+    return true;
+}
+
 void runtime::init() {
     util::log("initialising vk gpu test");
     SDL_Init(SDL_INIT_VIDEO);
 
     this->sdl_window = SDL_CreateWindow("vk gpu", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, (this->sdl_display_mode.w = 1280), (this->sdl_display_mode.h = 800), SDL_WINDOW_RESIZABLE | SDL_WINDOW_VULKAN);
-    if (this->renderer.init(this->sdl_window)) util::log("could not create vk instance");
-    this->renderer.debug_message();
-    this->renderer.create_surface(this->sdl_window);
+    this->renderer.add_window(this->sdl_window);
+
+    /* Extra windows share the device, pipelines and buffers, they only bring a surface and swap chain. */
+    for (uint32_t it {1}; it < this->window_count; it++) {
+        std::string title {"vk gpu " + std::to_string(it + 1)};
+        int32_t offset {static_cast<int32_t>(it) * 48};
+        this->renderer.add_window(SDL_CreateWindow(title.c_str(), offset, offset, 640, 400, SDL_WINDOW_RESIZABLE | SDL_WINDOW_VULKAN));
+    }
+
+    /* Disk reads and font loading do not need the device, so they overlap the Vulkan setup phases. */
+    this->renderer.startup.add("shader read", [this]() {
+        ekg::gpu::widget_tessellator::set_vertex_input(this->pipeline);
+        return ekg::load_pipeline_shaders(this->pipeline, "shaders/widget.vert.spv", "shaders/widget.frag.spv");
+    });
+
+    this->renderer.startup.add("tessellation shader read", [this]() {
+        return this->tessellator.load_shader("shaders/widget_tessellate.comp.spv");
+    });
+
+    /* Nothing depends on the font yet, a missing one is only logged. */
+    this->renderer.startup.add("font face", [this]() {
+        if (FT_Init_FreeType(&this->ft_library) || FT_New_Face(this->ft_library, this->font_path.c_str(), 0, &this->ft_face)) {
+            util::log("could not load font face");
+        }
+
+        return true;
+    });
+
+    this->renderer.startup.add("pipeline", [this]() {
+        return ekg::create_pipeline(this->pipeline);
+    }, {"shader read", "render pass", "pipeline layout"});
+
+    this->renderer.startup.add("sdf shader read", [this]() {
+        return this->sdf.load_shaders("shaders/sdf_primitive.vert.spv", "shaders/sdf_primitive.frag.spv");
+    });
+
+    this->renderer.startup.add("sdf renderer", [this]() {
+        return this->sdf.init(this->benchmark ? 100000 : 256);
+    }, {"sdf shader read", "render pass"});
+
+    this->renderer.startup.add("blur shader read", [this]() {
+        return this->blur.load_shaders("shaders/fullscreen.vert.spv", "shaders/blur.frag.spv");
+    });
+
+    this->renderer.startup.add("blur renderer", [this]() {
+        return this->blur.init();
+    }, {"blur shader read", "render pass"});
+
+    this->renderer.startup.add("widget tessellator", [this]() {
+        return this->tessellator.init(this->benchmark ? 100000 : 4096);
+    }, {"tessellation shader read", "logical device"});
+
+    /* Room for the CPU tessellation of the most `--bench` steps up to: 4 vertices and 6 indices a widget, 37 and 108 a rounded rect. */
+    if (this->benchmark) {
+        this->renderer.startup.add("cpu geometry", [this]() {
+            return this->cpu_widgets.init(100000 * 4, 100000 * 6) && this->cpu_rounded_rects.init(100000 * 37, 100000 * 108);
+        }, {"logical device"});
+
+        this->renderer.startup.add("timestamp queries", [this]() {
+            return this->create_timestamp_pool();
+        }, {"logical device"});
+    }
+
+    /* Startup windows get their passes once every task above is done, later ones as they are added. */
+    this->renderer.build_render_graph = [this](ekg::gpu::vk_window &window) {
+        return this->create_render_graph(window);
+    };
+
+    if (!this->renderer.setup()) {
+        util::log("could not set up the renderer");
+        return;
+    }
+
     this->mainloop_running = true;
+
+    /* Every 10s at 60 fps, how many frames still reached the heap; `--strict-host` also logs each of them. */
+    ekg::gpu::host.report_interval_frames = 600;
+
+    EKG_TRACE_INSTALL_SIGNAL();
 }
 
 void runtime::mainloop() {
@@ -27,30 +417,206 @@ void runtime::mainloop() {
     uint64_t fps = 1000 / 60;
     uint32_t elapsed_frames {};
     uint32_t display_fps {};
+    uint64_t frame {};
     SDL_Event sdl_event {};
 
+    /* With --bench the widget count steps up every 120 frames, logging the CPU cost of both paths. */
+    const uint32_t benchmark_counts[] {1000, 10000, 50000, 100000};
+    uint32_t benchmark_step {};
+    uint32_t benchmark_frames {};
+    double benchmark_gpu_driven_ms {};
+    double benchmark_cpu_tessellation_ms {};
+    double benchmark_sdf_ms {};
+    double benchmark_rounded_tessellation_ms {};
+    uint32_t benchmark_gpu_frames {};
+    double benchmark_gpu_ms[4] {};
+    std::vector<ekg::gpu::widget_vertex> cpu_vertices {};
+    std::vector<uint32_t> cpu_indices {};
+
+    this->generate_widgets(this->benchmark ? benchmark_counts[0] : 1024);
+    this->generate_primitives(this->benchmark ? benchmark_counts[0] : 0);
+
     while (this->mainloop_running) {
         if (timing_framerate.reach(fps) && timing_framerate.reset()) {
+            EKG_TRACE_SCOPE("frame");
+            ekg::gpu::host.begin_frame();
+
             if (timing_fps_count.reach(1000) && timing_fps_count.reset()) {
                 display_fps = elapsed_frames;
                 elapsed_frames = 0;
             }
 
             util::dt = static_cast<float>(timing_framerate.delta_ticks) / 100;
-            while (SDL_PollEvent(&sdl_event)) {
-                switch (sdl_event.type) {
-                    case SDL_QUIT: {
-                        this->mainloop_running = false;
-                        break;
+
+            {
+                EKG_TRACE_SCOPE("events");
+
+                while (SDL_PollEvent(&sdl_event)) {
+                    switch (sdl_event.type) {
+                        case SDL_QUIT: {
+                            this->mainloop_running = false;
+                            break;
+                        }
+
+                        case SDL_WINDOWEVENT: {
+                            if (sdl_event.window.event == SDL_WINDOWEVENT_CLOSE) {
+                                this->mainloop_running = false;
+                            } else if (sdl_event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                                ekg::gpu::vk_window *window {this->renderer.find_window(sdl_event.window.windowID)};
+                                if (window != nullptr) window->out_of_date = true;
+                            }
+
+                            break;
+                        }
+
+                        case SDL_KEYDOWN: {
+                            if (sdl_event.key.keysym.sym == SDLK_F12) {
+                                EKG_TRACE_REQUEST_DUMP();
+                            } else if (sdl_event.key.keysym.sym == SDLK_F2) {
+                                std::string title {"vk gpu " + std::to_string(this->renderer.windows.size() + 1)};
+                                this->renderer.add_window(SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 640, 400, SDL_WINDOW_RESIZABLE | SDL_WINDOW_VULKAN));
+                            }
+
+                            break;
+                        }
+                    }
+                }
+            }
+
+            VkCommandBuffer command_buffer {this->renderer.begin_frame()};
+            if (command_buffer != VK_NULL_HANDLE) {
+#ifdef EKG_TRACE
+                uint32_t image_indices[8] {};
+                uint32_t window_count {static_cast<uint32_t>(std::min<size_t>(this->renderer.windows.size(), std::size(image_indices)))};
+
+                for (uint32_t it {}; it < window_count; it++) {
+                    image_indices[it] = this->renderer.windows[it]->acquired ? this->renderer.windows[it]->current_image_index : UINT32_MAX;
+                }
+
+                EKG_TRACE_FRAME(frame, image_indices, window_count);
+#endif
+                /* The fence of the frame that wrote them is waited by now. */
+                if (this->timestamps_written) {
+                    uint64_t timestamps[timestamp_count] {};
+                    this->timestamps_written = false;
+
+                    if (vkGetQueryPoolResults(this->renderer.vk_device, this->timestamp_pool, 0, timestamp_count, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+                        auto span {[this, &timestamps](uint32_t begin, uint32_t end) {
+                            return static_cast<double>(timestamps[end] - timestamps[begin]) * static_cast<double>(this->timestamp_period) / 1000000.0;
+                        }};
+
+                        benchmark_gpu_ms[0] += span(timestamp_dispatch_begin, timestamp_dispatch_end) + span(timestamp_ui_begin, timestamp_widgets_end);
+                        benchmark_gpu_ms[1] += span(timestamp_sdf_end, timestamp_cpu_widgets_end);
+                        benchmark_gpu_ms[2] += span(timestamp_widgets_end, timestamp_sdf_end);
+                        benchmark_gpu_ms[3] += span(timestamp_cpu_widgets_end, timestamp_rounded_rects_end);
+                        benchmark_gpu_frames++;
+                    }
+                }
+
+                this->timings = {};
+                bool recorded {true};
+
+                {
+                    EKG_TRACE_SCOPE("recording");
+                    auto upload_begin {std::chrono::steady_clock::now()};
+                    this->tessellator.upload(this->widgets.data(), static_cast<uint32_t>(this->widgets.size()));
+                    auto sdf_begin {std::chrono::steady_clock::now()};
+                    this->sdf.upload(this->primitives.data(), static_cast<uint32_t>(this->primitives.size()));
+                    auto sdf_end {std::chrono::steady_clock::now()};
+
+                    this->timings.gpu_driven += sdf_begin - upload_begin;
+                    this->timings.sdf += sdf_end - sdf_begin;
+
+                    if (this->benchmark) {
+                        VkExtent2D extent {this->renderer.windows.front()->vk_swap_chain_extent};
+                        tessellate_on_cpu(this->widgets, cpu_vertices, cpu_indices, static_cast<float>(extent.width), static_cast<float>(extent.height));
+                        this->cpu_widgets.upload(cpu_vertices, cpu_indices);
+                        auto tessellation_end {std::chrono::steady_clock::now()};
+
+                        tessellate_rounded_rects_on_cpu(this->primitives, cpu_vertices, cpu_indices, 8, static_cast<float>(extent.width), static_cast<float>(extent.height));
+                        this->cpu_rounded_rects.upload(cpu_vertices, cpu_indices);
+                        this->timings.cpu_tessellation += tessellation_end - sdf_end;
+                        this->timings.rounded_tessellation += std::chrono::steady_clock::now() - tessellation_end;
+                    }
+
+                    for (std::unique_ptr<ekg::gpu::vk_window> &window : this->renderer.windows) {
+                        if (window->acquired && !window->graph.execute(command_buffer)) {
+                            recorded = false;
+                            break;
+                        }
+                    }
+                }
+
+                /* Submit and present stay out of the bench, every path above pays them the same. */
+                if (recorded) {
+                    this->renderer.end_frame();
+                } else {
+                    this->renderer.cancel_frame();
+                    this->timestamps_written = false;
+                }
+
+                if (this->benchmark && recorded) {
+                    benchmark_gpu_driven_ms += std::chrono::duration<double, std::milli>(this->timings.gpu_driven).count();
+                    benchmark_cpu_tessellation_ms += std::chrono::duration<double, std::milli>(this->timings.cpu_tessellation).count();
+                    benchmark_sdf_ms += std::chrono::duration<double, std::milli>(this->timings.sdf).count();
+                    benchmark_rounded_tessellation_ms += std::chrono::duration<double, std::milli>(this->timings.rounded_tessellation).count();
+
+                    if (++benchmark_frames == 120) {
+                        char buffer[192] {};
+                        std::snprintf(buffer, sizeof(buffer), "bench: %6u widgets, upload and recording: gpu-driven %.3fms cpu/frame, cpu tessellation %.3fms cpu/frame", benchmark_counts[benchmark_step], benchmark_gpu_driven_ms / 120.0, benchmark_cpu_tessellation_ms / 120.0);
+                        util::log(buffer);
+
+                        std::snprintf(buffer, sizeof(buffer), "bench: %6u rounded rects, sdf %u vertices %.3fms cpu/frame, tessellated %zu vertices %zu indices %.3fms cpu/frame", benchmark_counts[benchmark_step], benchmark_counts[benchmark_step] * 4, benchmark_sdf_ms / 120.0, cpu_vertices.size(), cpu_indices.size(), benchmark_rounded_tessellation_ms / 120.0);
+                        util::log(buffer);
+
+                        if (benchmark_gpu_frames != 0) {
+                            std::snprintf(buffer, sizeof(buffer), "bench: %6u widgets, gpu time: gpu-driven %.3fms/frame, cpu tessellation %.3fms/frame", benchmark_counts[benchmark_step], benchmark_gpu_ms[0] / benchmark_gpu_frames, benchmark_gpu_ms[1] / benchmark_gpu_frames);
+                            util::log(buffer);
+
+                            std::snprintf(buffer, sizeof(buffer), "bench: %6u rounded rects, gpu time: sdf %.3fms/frame, tessellated %.3fms/frame", benchmark_counts[benchmark_step], benchmark_gpu_ms[2] / benchmark_gpu_frames, benchmark_gpu_ms[3] / benchmark_gpu_frames);
+                            util::log(buffer);
+                        }
+
+                        benchmark_frames = 0;
+                        benchmark_gpu_frames = 0;
+                        std::fill(std::begin(benchmark_gpu_ms), std::end(benchmark_gpu_ms), 0.0);
+                        this->timestamps_written = false;
+                        benchmark_gpu_driven_ms = 0.0;
+                        benchmark_cpu_tessellation_ms = 0.0;
+                        benchmark_sdf_ms = 0.0;
+                        benchmark_rounded_tessellation_ms = 0.0;
+
+                        if (++benchmark_step == std::size(benchmark_counts)) {
+                            this->mainloop_running = false;
+                        } else {
+                            this->generate_widgets(benchmark_counts[benchmark_step]);
+                            this->generate_primitives(benchmark_counts[benchmark_step]);
+                        }
                     }
                 }
             }
 
+            ekg::gpu::host.end_frame();
+            EKG_TRACE_POLL_DUMP("vk_ekg_trace.json", 300);
+
             elapsed_frames++;
+            frame++;
         }
     }
 }
 
 void runtime::quit() {
+    if (this->renderer.vk_device != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(this->renderer.vk_device);
+        this->tessellator.destroy();
+        this->sdf.destroy();
+        this->blur.destroy();
+        this->cpu_widgets.destroy();
+        this->cpu_rounded_rects.destroy();
+        vkDestroyQueryPool(this->renderer.vk_device, this->timestamp_pool, ekg::gpu::host.get_callbacks());
+        vkDestroyPipeline(this->renderer.vk_device, this->pipeline.pipeline_info, ekg::gpu::host.get_callbacks());
+    }
+
+    ekg::gpu::host.report();
     this->renderer.quit();
 }
@@ -3,17 +3,76 @@
 
 #include <SDL2/SDL.h>
 #include "ekg/gpu/gpu_vk_renderer.hpp"
+#include "ekg/gpu/gpu_vk_pipeline.hpp"
+#include "ekg/gpu/gpu_vk_tessellator.hpp"
+#include "ekg/gpu/gpu_vk_sdf.hpp"
+#include "ekg/gpu/gpu_vk_blur.hpp"
+#include <chrono>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/* Host visible vertex and index buffers, what a CPU tessellation path uploads into and draws from. */
+struct cpu_geometry {
+    VkBuffer vertex_buffer {};
+    VkDeviceMemory vertex_memory {};
+    void *mapped_vertices {};
+    VkBuffer index_buffer {};
+    VkDeviceMemory index_memory {};
+    void *mapped_indices {};
+    uint32_t vertex_capacity {};
+    uint32_t index_capacity {};
+    uint32_t index_count {};
+
+    bool init(uint32_t max_vertices, uint32_t max_indices);
+    void upload(const std::vector<ekg::gpu::widget_vertex> &vertices, const std::vector<uint32_t> &indices);
+    void draw(VkCommandBuffer command_buffer, ekg::gpu::pipeline &pipeline);
+    void destroy();
+};
+
+/* Upload plus command recording of each `--bench` path, summed over every window of a frame. */
+struct frame_timings {
+    std::chrono::steady_clock::duration gpu_driven {};
+    std::chrono::steady_clock::duration cpu_tessellation {};
+    std::chrono::steady_clock::duration sdf {};
+    std::chrono::steady_clock::duration rounded_tessellation {};
+};
 
 class runtime {
 protected:
     SDL_DisplayMode sdl_display_mode {};
     SDL_Window* sdl_window {};
+    uint32_t window_count {1};
 
     bool mainloop_running {false};
-    ekg::gpu::vk_renderer renderer {};
+    ekg::gpu::vk_renderer &renderer {ekg::gpu::vulkan};
+    ekg::gpu::pipeline pipeline {};
+    ekg::gpu::widget_tessellator tessellator {};
+    std::vector<ekg::gpu::widget_descriptor> widgets {};
+    ekg::gpu::sdf_renderer sdf {};
+    std::vector<ekg::gpu::sdf_primitive> primitives {};
+    ekg::gpu::blur_renderer blur {};
+    bool benchmark {};
+    cpu_geometry cpu_widgets {};
+    cpu_geometry cpu_rounded_rects {};
+    frame_timings timings {};
+
+    /* GPU timestamps around every `--bench` path of the first window, null where the device has none. */
+    VkQueryPool timestamp_pool {};
+    float timestamp_period {};
+    bool timestamps_written {};
+
+    FT_Library ft_library {};
+    FT_Face ft_face {};
+    std::string font_path {"whitneybook.otf"};
 public:
     SDL_DisplayMode &get_display_mode();
     SDL_Window* get_sdl_window();
+    void set_benchmark(bool benchmark_mode);
+    void set_window_count(uint32_t count);
+    void generate_widgets(uint32_t count);
+    void generate_primitives(uint32_t count);
+    bool create_render_graph(ekg::gpu::vk_window &created_window);
+    bool create_timestamp_pool();
 
     void init();
     void mainloop();